@@ -0,0 +1,322 @@
+/**
+ * @file etf_benchmark.cpp
+ * @brief Native benchmark suite for the experimental target features.
+ * @details Runs without MATLAB/Simulink and writes all results as a single JSON document to stdout or to a file, so that
+ * results can be tracked across releases. Usage:
+ *
+ *     etf_benchmark [--quick] [--directory <dir>] [--output <file.json>]
+ *
+ * --quick      Reduce the number of iterations and the amount of data (e.g. for CI).
+ * --directory  Scratch directory for ring buffer and startup files (default: system temporary directory).
+ * --output     JSON file to be written (default: stdout).
+ */
+
+
+/* Include standard libraries */
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+
+/* Include etf headers */
+#include <etf_binary_ring_buffer.hpp>
+#include <etf_startup_file.hpp>
+
+
+/**
+ * @brief Global benchmark configuration.
+ */
+struct BenchmarkConfiguration {
+    bool quick = false;                  // True if iterations and data sizes should be reduced.
+    std::filesystem::path directory;     // Scratch directory for all files.
+    std::string output;                  // Output JSON file, empty for stdout.
+};
+
+
+/**
+ * @brief Helper for writing a JSON document with comma handling.
+ */
+class JSONWriter {
+    public:
+        explicit JSONWriter(FILE* fp): fp(fp), first(true) {}
+
+        void Raw(const char* text){ fprintf(fp, "%s", text); first = false; }
+        void Key(const char* key){ Separator(); fprintf(fp, "\"%s\": ", key); first = true; }
+        void BeginObject(void){ Separator(); fprintf(fp, "{"); first = true; }
+        void EndObject(void){ fprintf(fp, "}"); first = false; }
+        void BeginArray(void){ Separator(); fprintf(fp, "["); first = true; }
+        void EndArray(void){ fprintf(fp, "]"); first = false; }
+        void String(const char* value){ Separator(); fprintf(fp, "\"%s\"", value); first = false; }
+        void Number(double value){ Separator(); fprintf(fp, "%.9g", value); first = false; }
+        void Integer(uint64_t value){ Separator(); fprintf(fp, "%llu", static_cast<unsigned long long>(value)); first = false; }
+
+    private:
+        FILE* fp;     // Output stream.
+        bool first;   // True if no separator is required for the next value.
+
+        void Separator(void){ if(!first){ fprintf(fp, ", "); } first = false; }
+};
+
+
+/**
+ * @brief Get the current time of the steady clock in nanoseconds.
+ */
+static inline uint64_t NowNs(void){
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+
+/**
+ * @brief Write percentiles of a set of durations as JSON object members (in seconds).
+ * @param[in] json The JSON writer.
+ * @param[in] durationsNs Durations in nanoseconds, will be sorted.
+ */
+static void WritePercentiles(JSONWriter& json, std::vector<uint64_t>& durationsNs){
+    std::sort(durationsNs.begin(), durationsNs.end());
+    auto percentile = [&durationsNs](double p) -> double {
+        if(durationsNs.empty()){
+            return 0.0;
+        }
+        size_t k = static_cast<size_t>(p * static_cast<double>(durationsNs.size() - 1) + 0.5);
+        return 1e-9 * static_cast<double>(durationsNs[k]);
+    };
+    double sum = 0.0;
+    for(auto&& d : durationsNs){
+        sum += 1e-9 * static_cast<double>(d);
+    }
+    json.Key("count"); json.Integer(durationsNs.size());
+    json.Key("mean_s"); json.Number(durationsNs.empty() ? 0.0 : (sum / static_cast<double>(durationsNs.size())));
+    json.Key("p50_s"); json.Number(percentile(0.5));
+    json.Key("p90_s"); json.Number(percentile(0.9));
+    json.Key("p99_s"); json.Number(percentile(0.99));
+    json.Key("p999_s"); json.Number(percentile(0.999));
+    json.Key("max_s"); json.Number(durationsNs.empty() ? 0.0 : (1e-9 * static_cast<double>(durationsNs.back())));
+}
+
+
+/**
+ * @brief Measure the step time of BinaryRingBuffer::AddSample at a fixed sample rate.
+ * @details Samples are added at 10 kHz, which is well above the typical model rate, while the worker thread drains the cache.
+ */
+static void BenchmarkAddSample(JSONWriter& json, const BenchmarkConfiguration& cfg){
+    const size_t numSteps = cfg.quick ? 5000 : 50000;
+    const auto period = std::chrono::microseconds(100);
+    json.Key("binary_ring_buffer_add_sample");
+    json.BeginArray();
+    for(size_t sampleSize : {64, 1024, 8192}){
+        std::filesystem::path folder = cfg.directory / "add_sample";
+        std::vector<uint8_t> sample(sampleSize, 0);
+        std::vector<uint64_t> durations;
+        durations.reserve(numSteps);
+        etf::BinaryRingBuffer ringBuffer;
+        ringBuffer.Initialize(folder.string().c_str(), sampleSize, 10000, 4, 0, 4096);
+        auto nextStep = std::chrono::steady_clock::now();
+        for(size_t k = 0; k < numSteps; ++k){
+            std::memcpy(&sample[0], &k, sizeof(k));
+            uint64_t t0 = NowNs();
+            (void) ringBuffer.AddSample(&sample[0], false);
+            durations.push_back(NowNs() - t0);
+            nextStep += period;
+            std::this_thread::sleep_until(nextStep);
+        }
+        size_t numDropped = ringBuffer.GetNumDroppedSamples();
+        ringBuffer.Terminate();
+        std::filesystem::remove_all(folder);
+        json.BeginObject();
+        json.Key("sample_size"); json.Integer(sampleSize);
+        json.Key("sample_rate_hz"); json.Number(1e6 / static_cast<double>(period.count()));
+        json.Key("num_dropped_samples"); json.Integer(numDropped);
+        WritePercentiles(json, durations);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+
+/**
+ * @brief Measure the throughput of MultiFileRingBuffer::Write across sample sizes, file counts and backends.
+ */
+static void BenchmarkMultiFileWrite(JSONWriter& json, const BenchmarkConfiguration& cfg){
+    const size_t numBytesTotal = cfg.quick ? (size_t(16) << 20) : (size_t(256) << 20);
+    const size_t numBytesPerBatch = size_t(64) << 10;
+    const std::pair<const char*, etf::detail::MultiFileRingBufferBackend> backends[] = {
+        {"stdio_stream", etf::detail::MultiFileRingBufferBackend::stdio_stream},
+        {"memory_mapped", etf::detail::MultiFileRingBufferBackend::memory_mapped},
+        {"direct_io", etf::detail::MultiFileRingBufferBackend::direct_io},
+        {"io_uring_async", etf::detail::MultiFileRingBufferBackend::io_uring_async}
+    };
+    json.Key("multi_file_ring_buffer_write");
+    json.BeginArray();
+    std::vector<uint8_t> data(numBytesPerBatch, 0x5A);
+    for(auto&& [backendName, backend] : backends){
+        for(size_t sampleSize : {16, 64, 1024, 4096}){
+            for(size_t numFiles : {1, 4, 16}){
+                std::filesystem::path folder = cfg.directory / "multi_file_write";
+                size_t numSamplesPerBatch = numBytesPerBatch / sampleSize;
+                size_t numSamplesPerFile = numBytesTotal / (sampleSize * numFiles * 2);
+                etf::detail::MultiFileRingBufferOptions options;
+                options.backend = backend;
+                options.flush_bytes = size_t(1) << 20;
+                etf::detail::MultiFileRingBuffer ringBuffer;
+                bool opened = ringBuffer.Open(folder.string().c_str(), sampleSize, numSamplesPerFile, numFiles, options);
+                uint64_t t0 = NowNs();
+                size_t numBytesWritten = 0;
+                if(opened){
+                    for(; numBytesWritten < numBytesTotal; numBytesWritten += numSamplesPerBatch * sampleSize){
+                        ringBuffer.Write(&data[0], numSamplesPerBatch);
+                    }
+                    ringBuffer.Close();
+                }
+                double duration = 1e-9 * static_cast<double>(NowNs() - t0);
+                std::filesystem::remove_all(folder);
+                json.BeginObject();
+                json.Key("backend"); json.String(backendName);
+                json.Key("sample_size"); json.Integer(sampleSize);
+                json.Key("num_files"); json.Integer(numFiles);
+                json.Key("opened"); json.Raw(opened ? "true" : "false");
+                json.Key("bytes_written"); json.Integer(numBytesWritten);
+                json.Key("duration_s"); json.Number(duration);
+                json.Key("bytes_per_second"); json.Number((duration > 0.0) ? (static_cast<double>(numBytesWritten) / duration) : 0.0);
+                json.EndObject();
+            }
+        }
+    }
+    json.EndArray();
+}
+
+
+/**
+ * @brief Measure the latency from NotifyableThread::Notify until the callback is running.
+ */
+static void BenchmarkNotifyableThread(JSONWriter& json, const BenchmarkConfiguration& cfg){
+    const size_t numWakeups = cfg.quick ? 2000 : 20000;
+    std::atomic<uint64_t> timeOfNotify(0);
+    std::atomic<uint64_t> latency(0);
+    std::atomic<bool> done(false);
+    etf::detail::NotifyableThread thread;
+    const int startResult = thread.Start([&](){
+        latency = NowNs() - timeOfNotify.load();
+        done = true;
+    }, etf::detail::ThreadOptions{etf::detail::ThreadPolicy::other, 0, {}});
+    if(startResult){
+        fprintf(stderr, "could not apply the thread options of the notifyable thread: %s\n", strerror(startResult));
+    }
+    std::vector<uint64_t> durations;
+    durations.reserve(numWakeups);
+    for(size_t k = 0; k < numWakeups; ++k){
+        done = false;
+        timeOfNotify = NowNs();
+        thread.Notify();
+        while(!done){
+            std::this_thread::yield();
+        }
+        durations.push_back(latency.load());
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    thread.Stop();
+    json.Key("notifyable_thread_wakeup");
+    json.BeginObject();
+    json.Key("start_result"); json.Integer(startResult);
+    WritePercentiles(json, durations);
+    json.EndObject();
+}
+
+
+/**
+ * @brief Measure the load time of StartupFile::Initialize for large files.
+ * @details The file is read repeatedly, so the results mainly reflect reading from the page cache.
+ */
+static void BenchmarkStartupFile(JSONWriter& json, const BenchmarkConfiguration& cfg){
+    const size_t numRepetitions = cfg.quick ? 3 : 10;
+    json.Key("startup_file_initialize");
+    json.BeginArray();
+    std::vector<size_t> fileSizes = {size_t(1) << 20, size_t(16) << 20};
+    if(!cfg.quick){
+        fileSizes.push_back(size_t(256) << 20);
+    }
+    for(size_t fileSize : fileSizes){
+        std::filesystem::path filename = cfg.directory / "startup_file.bin";
+        FILE* fp = fopen(filename.string().c_str(), "wb");
+        if(fp){
+            std::vector<uint8_t> block(size_t(1) << 20, 0xA5);
+            for(size_t n = 0; n < fileSize; n += block.size()){
+                fwrite(&block[0], 1, block.size(), fp);
+            }
+            fclose(fp);
+        }
+        std::vector<uint64_t> durations;
+        for(size_t k = 0; k < numRepetitions; ++k){
+            etf::StartupFile startupFile;
+            uint64_t t0 = NowNs();
+            startupFile.Initialize(filename.string().c_str(), static_cast<uint32_t>(fileSize));
+            durations.push_back(NowNs() - t0);
+            startupFile.Terminate();
+        }
+        std::filesystem::remove(filename);
+        json.BeginObject();
+        json.Key("file_size"); json.Integer(fileSize);
+        WritePercentiles(json, durations);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+
+int main(int argc, char** argv){
+    BenchmarkConfiguration cfg;
+    cfg.directory = std::filesystem::temp_directory_path();
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        if(arg == "--quick"){
+            cfg.quick = true;
+        }
+        else if((arg == "--directory") && ((i + 1) < argc)){
+            cfg.directory = argv[++i];
+        }
+        else if((arg == "--output") && ((i + 1) < argc)){
+            cfg.output = argv[++i];
+        }
+        else{
+            fprintf(stderr, "usage: %s [--quick] [--directory <dir>] [--output <file.json>]\n", argv[0]);
+            return 1;
+        }
+    }
+    cfg.directory /= "etf_benchmark_" + std::to_string(static_cast<long long>(getpid()));
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.directory, ec);
+    if(ec){
+        fprintf(stderr, "could not create directory %s\n", cfg.directory.string().c_str());
+        return 1;
+    }
+    FILE* fp = cfg.output.empty() ? stdout : fopen(cfg.output.c_str(), "w");
+    if(!fp){
+        fprintf(stderr, "could not open %s\n", cfg.output.c_str());
+        return 1;
+    }
+
+    JSONWriter json(fp);
+    json.BeginObject();
+    json.Key("schema_version"); json.Integer(1);
+    json.Key("quick"); json.Raw(cfg.quick ? "true" : "false");
+    json.Key("hardware_concurrency"); json.Integer(std::thread::hardware_concurrency());
+    BenchmarkAddSample(json, cfg);
+    BenchmarkMultiFileWrite(json, cfg);
+    BenchmarkNotifyableThread(json, cfg);
+    BenchmarkStartupFile(json, cfg);
+    json.EndObject();
+    fprintf(fp, "\n");
+
+    if(fp != stdout){
+        fclose(fp);
+    }
+    std::filesystem::remove_all(cfg.directory, ec);
+    return 0;
+}
@@ -1,12 +1,45 @@
 #include <ETFDriver_BinaryRingBuffer.hpp>
 #include <etf_binary_ring_buffer.hpp>
 #include <string>
+#include <chrono>
 
 
-void ETFDriver_BinaryRingBufferInitialize(void** workVector, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority){
-    etf::BinaryRingBuffer* driver = new etf::BinaryRingBuffer();
+void ETFDriver_BinaryRingBufferSetup(etf::BinaryRingBuffer* driver, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority, uint32_t maxNumCachedSamples, uint8_t overflowPolicy, uint32_t overflowTimeoutUs, uint32_t statisticsPeriodMs, uint32_t writerGroup, uint32_t numWriterThreads, uint8_t threadPolicy, uint32_t* threadCpus, uint32_t numThreadCpus, uint32_t notifyWatermark, uint32_t maxNotifyLatencyUs, uint8_t variableLength, uint8_t durability, uint32_t syncPeriodMs, uint8_t backend, uint8_t preallocate, uint32_t flushBytes, uint32_t flushPeriodMs, uint32_t asyncNumBuffers, uint32_t asyncBufferSize, uint8_t codec, uint32_t blockNumSamples, uint8_t filter, uint32_t keyframeInterval, uint32_t journalIntervalSamples, uint32_t syncBytes, uint32_t timeIndexIntervalSamples){
     std::string folder((char*)folderName, strlenFolderName);
-    driver->Initialize(folder.c_str(), sampleSize, numSamplesPerFile, numFiles, threadPriority);
+    etf::detail::ThreadOptions threadOptions;
+    threadOptions.policy = static_cast<etf::detail::ThreadPolicy>(threadPolicy);
+    threadOptions.priority = threadPriority;
+    for(uint32_t i = 0; threadCpus && (i < numThreadCpus); ++i){
+        threadOptions.cpus.push_back(static_cast<int>(threadCpus[i]));
+    }
+    driver->SetThreadOptions(threadOptions);
+    driver->SetWakeupCoalescing(notifyWatermark, maxNotifyLatencyUs);
+    if(writerGroup){
+        driver->SetWriterService(etf::detail::WriterService::Acquire(writerGroup, numWriterThreads, threadOptions, std::chrono::microseconds(maxNotifyLatencyUs)));
+    }
+    etf::detail::MultiFileRingBufferOptions fileOptions;
+    fileOptions.variable_length = static_cast<bool>(variableLength);
+    fileOptions.durability = static_cast<etf::detail::MultiFileRingBufferDurability>(durability);
+    fileOptions.sync_period_ms = syncPeriodMs;
+    fileOptions.backend = static_cast<etf::detail::MultiFileRingBufferBackend>(backend);
+    fileOptions.preallocate = static_cast<bool>(preallocate);
+    fileOptions.flush_bytes = flushBytes;
+    fileOptions.flush_period_ms = flushPeriodMs;
+    fileOptions.async_num_buffers = asyncNumBuffers ? asyncNumBuffers : fileOptions.async_num_buffers;
+    fileOptions.async_buffer_size = asyncBufferSize ? asyncBufferSize : fileOptions.async_buffer_size;
+    fileOptions.codec = static_cast<etf::detail::MultiFileRingBufferCodec>(codec);
+    fileOptions.block_num_samples = blockNumSamples ? blockNumSamples : fileOptions.block_num_samples;
+    fileOptions.filter = static_cast<etf::detail::MultiFileRingBufferFilter>(filter);
+    fileOptions.keyframe_interval = keyframeInterval;
+    fileOptions.journal_interval_samples = journalIntervalSamples;
+    fileOptions.sync_bytes = syncBytes;
+    fileOptions.time_index_interval_samples = timeIndexIntervalSamples;
+    driver->Initialize(folder.c_str(), sampleSize, numSamplesPerFile, numFiles, threadPriority, maxNumCachedSamples, static_cast<etf::OverflowPolicy>(overflowPolicy), overflowTimeoutUs, statisticsPeriodMs, fileOptions);
+}
+
+void ETFDriver_BinaryRingBufferInitialize(void** workVector, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority, uint32_t maxNumCachedSamples, uint8_t overflowPolicy, uint32_t overflowTimeoutUs, uint32_t statisticsPeriodMs, uint32_t writerGroup, uint32_t numWriterThreads, uint8_t threadPolicy, uint32_t* threadCpus, uint32_t numThreadCpus, uint32_t notifyWatermark, uint32_t maxNotifyLatencyUs, uint8_t variableLength, uint8_t durability, uint32_t syncPeriodMs, uint8_t backend, uint8_t preallocate, uint32_t flushBytes, uint32_t flushPeriodMs, uint32_t asyncNumBuffers, uint32_t asyncBufferSize, uint8_t codec, uint32_t blockNumSamples, uint8_t filter, uint32_t keyframeInterval, uint32_t journalIntervalSamples, uint32_t syncBytes, uint32_t timeIndexIntervalSamples){
+    etf::BinaryRingBuffer* driver = new etf::BinaryRingBuffer();
+    ETFDriver_BinaryRingBufferSetup(driver, folderName, strlenFolderName, sampleSize, numSamplesPerFile, numFiles, threadPriority, maxNumCachedSamples, overflowPolicy, overflowTimeoutUs, statisticsPeriodMs, writerGroup, numWriterThreads, threadPolicy, threadCpus, numThreadCpus, notifyWatermark, maxNotifyLatencyUs, variableLength, durability, syncPeriodMs, backend, preallocate, flushBytes, flushPeriodMs, asyncNumBuffers, asyncBufferSize, codec, blockNumSamples, filter, keyframeInterval, journalIntervalSamples, syncBytes, timeIndexIntervalSamples);
     *workVector = reinterpret_cast<void*>(driver);
 }
 
@@ -16,9 +49,41 @@ void ETFDriver_BinaryRingBufferTerminate(void* workVector){
     delete driver;
 }
 
-void ETFDriver_BinaryRingBufferStep(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint8_t* sampleData, uint8_t startNewRingBuffer){
+void ETFDriver_BinaryRingBufferStep(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, uint8_t* sampleData, uint8_t startNewRingBuffer){
     etf::BinaryRingBuffer* driver = reinterpret_cast<etf::BinaryRingBuffer*>(workVector);
     *isOpen = static_cast<uint8_t>(driver->IsOpen());
     *numCachedSamples = driver->AddSample(sampleData, static_cast<bool>(startNewRingBuffer));
+    *numDroppedSamples = static_cast<uint32_t>(driver->GetNumDroppedSamples());
+    *threadError = static_cast<int32_t>(driver->GetThreadError());
+}
+
+void ETFDriver_BinaryRingBufferStepVariableLength(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, uint8_t* sampleData, uint8_t startNewRingBuffer, uint32_t sampleLength){
+    etf::BinaryRingBuffer* driver = reinterpret_cast<etf::BinaryRingBuffer*>(workVector);
+    *isOpen = static_cast<uint8_t>(driver->IsOpen());
+    *numCachedSamples = driver->AddSample(sampleData, sampleLength, static_cast<bool>(startNewRingBuffer));
+    *numDroppedSamples = static_cast<uint32_t>(driver->GetNumDroppedSamples());
+    *threadError = static_cast<int32_t>(driver->GetThreadError());
+}
+
+void ETFDriver_BinaryRingBufferStepStatistics(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, double* statistics, uint8_t* sampleData, uint8_t startNewRingBuffer){
+    ETFDriver_BinaryRingBufferStep(workVector, isOpen, numCachedSamples, numDroppedSamples, threadError, sampleData, startNewRingBuffer);
+    reinterpret_cast<etf::BinaryRingBuffer*>(workVector)->GetStatistics(statistics);
 }
 
+void ETFDriver_BinaryRingBufferStepVariableLengthStatistics(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, double* statistics, uint8_t* sampleData, uint8_t startNewRingBuffer, uint32_t sampleLength){
+    ETFDriver_BinaryRingBufferStepVariableLength(workVector, isOpen, numCachedSamples, numDroppedSamples, threadError, sampleData, startNewRingBuffer, sampleLength);
+    reinterpret_cast<etf::BinaryRingBuffer*>(workVector)->GetStatistics(statistics);
+}
+
+
+void ETFDriver_BinaryRingBufferReserve(void* workVector, void** sampleData){
+    etf::BinaryRingBuffer* driver = reinterpret_cast<etf::BinaryRingBuffer*>(workVector);
+    *sampleData = driver->ReserveSample();
+}
+
+void ETFDriver_BinaryRingBufferCommit(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, uint8_t startNewRingBuffer, uint32_t sampleLength){
+    etf::BinaryRingBuffer* driver = reinterpret_cast<etf::BinaryRingBuffer*>(workVector);
+    *isOpen = static_cast<uint8_t>(driver->IsOpen());
+    *numCachedSamples = driver->CommitSample(static_cast<bool>(startNewRingBuffer), sampleLength);
+    *numDroppedSamples = static_cast<uint32_t>(driver->GetNumDroppedSamples());
+}
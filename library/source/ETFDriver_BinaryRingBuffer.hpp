@@ -1,7 +1,12 @@
 #pragma once
 
 
+#ifdef __cplusplus
 #include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif
 
 
 /**
@@ -13,8 +18,35 @@
  * @param[in] numSamplesPerFile The number of samples to store in each file.
  * @param[in] numFiles The number of files to create.
  * @param[in] threadPriority The priority of the internal worker thread.
+ * @param[in] maxNumCachedSamples The maximum number of samples to be cached in memory. The memory is preallocated and no heap memory is allocated during the step. Zero selects a default value.
+ * @param[in] overflowPolicy Policy if the cache is full: 0 (drop newest sample), 1 (drop oldest sample), 2 (block until there is room or the timeout expires).
+ * @param[in] overflowTimeoutUs The maximum time in microseconds to block if the overflow policy is 2.
+ * @param[in] statisticsPeriodMs The period in milliseconds for writing a "statistics.json" file to the active ring buffer directory. Zero disables the file.
+ * @param[in] writerGroup Identifier of a shared writer service. All binary ring buffers with the same non-zero identifier share the worker threads and the housekeeping thread of that service. Zero selects dedicated threads for this ring buffer.
+ * @param[in] numWriterThreads The number of worker threads of the shared writer service. Only used by the first ring buffer that creates the service.
+ * @param[in] threadPolicy The scheduling policy of all threads: 0 (SCHED_FIFO), 1 (SCHED_RR), 2 (SCHED_OTHER, the thread priority is used as nice value).
+ * @param[in] threadCpus List of CPU indices the threads may run on. Use this to keep the threads away from the CPU that runs the model step.
+ * @param[in] numThreadCpus The number of CPU indices in threadCpus. Zero does not change the CPU affinity.
+ * @param[in] notifyWatermark The worker thread is only notified if at least this number of samples is cached. Requires a non-zero maxNotifyLatencyUs.
+ * @param[in] maxNotifyLatencyUs The maximum time in microseconds between two wakeups of the worker thread. Zero notifies the worker thread after each sample. For a shared writer service, the value of the ring buffer that creates the service is used.
+ * @param[in] variableLength Non-zero to write each sample as a record of a uint32 length followed by the valid bytes of the sample. The sample size is the maximum length. Zero writes all samples with the full sample size.
+ * @param[in] durability The durability tier of the files: 0 (never synchronized explicitly), 1 (synchronized when a ring buffer is closed), 2 (also synchronized periodically and when a file is completed).
+ * @param[in] syncPeriodMs The period in milliseconds for synchronizing the current file if the durability tier is 2. If syncPeriodMs and syncBytes are zero, the file is synchronized after every write of the worker thread.
+ * @param[in] backend The backend for writing the files: 0 (buffered stdio streams), 1 (memory-mapped files), 2 (O_DIRECT with an aligned staging buffer), 3 (asynchronous writes via io_uring, falls back to 0 if io_uring is not available).
+ * @param[in] preallocate Non-zero to reserve the disk space of all files when a ring buffer is opened.
+ * @param[in] flushBytes Flush buffered data once at least this number of bytes has been written since the last flush. If flushBytes and flushPeriodMs are zero, data is flushed after every write of the worker thread.
+ * @param[in] flushPeriodMs Flush buffered data if this period in milliseconds has elapsed since the last flush. Zero disables the period.
+ * @param[in] asyncNumBuffers The number of staging buffers and therefore the maximum number of writes in flight if the backend is 3. Zero selects a default value.
+ * @param[in] asyncBufferSize The size of each staging buffer in bytes if the backend is 3. Zero selects a default value.
+ * @param[in] codec The codec for compressing blocks of samples: 0 (none), 1 (LZ4 block format).
+ * @param[in] blockNumSamples The number of samples per block if a codec or a filter is selected. Zero selects a default value.
+ * @param[in] filter The filter that is applied to each block before it is compressed: 0 (none), 1 (XOR with the previous sample), 2 (delta to the previous sample).
+ * @param[in] keyframeInterval Additional unfiltered sample every keyframeInterval samples if a filter is selected. Zero stores unfiltered samples at block starts only.
+ * @param[in] journalIntervalSamples Record the writing point in a "journal.bin" file every journalIntervalSamples samples. Zero disables the journal.
+ * @param[in] syncBytes Synchronize the current file once at least this number of bytes has been written since the last synchronization if the durability tier is 2.
+ * @param[in] timeIndexIntervalSamples Add an entry to the time index file of the current file every timeIndexIntervalSamples samples. Zero disables the time index.
  */
-void ETFDriver_BinaryRingBufferInitialize(void** workVector, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority);
+void ETFDriver_BinaryRingBufferInitialize(void** workVector, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority, uint32_t maxNumCachedSamples, uint8_t overflowPolicy, uint32_t overflowTimeoutUs, uint32_t statisticsPeriodMs, uint32_t writerGroup, uint32_t numWriterThreads, uint8_t threadPolicy, uint32_t* threadCpus, uint32_t numThreadCpus, uint32_t notifyWatermark, uint32_t maxNotifyLatencyUs, uint8_t variableLength, uint8_t durability, uint32_t syncPeriodMs, uint8_t backend, uint8_t preallocate, uint32_t flushBytes, uint32_t flushPeriodMs, uint32_t asyncNumBuffers, uint32_t asyncBufferSize, uint8_t codec, uint32_t blockNumSamples, uint8_t filter, uint32_t keyframeInterval, uint32_t journalIntervalSamples, uint32_t syncBytes, uint32_t timeIndexIntervalSamples);
 
 /**
  * @brief Terminate the binary ring buffer.
@@ -28,8 +60,135 @@ void ETFDriver_BinaryRingBufferTerminate(void* workVector);
  * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
  * @param[out] isOpen Pointer to store the open status of the ring buffer.
  * @param[out] numCachedSamples Pointer to store the number of cached samples waiting to be written to disk.
+ * @param[out] numDroppedSamples Pointer to store the number of samples that have been discarded because the cache was full.
+ * @param[out] threadError Pointer to store the result of applying the thread options during initialization: zero on success, otherwise the error number of the first operation that failed.
  * @param[in] sampleData Pointer to the sample data to add. The size must be equal to the sample size specified during initialization.
  * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
  */
-void ETFDriver_BinaryRingBufferStep(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint8_t* sampleData, uint8_t startNewRingBuffer);
+void ETFDriver_BinaryRingBufferStep(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, uint8_t* sampleData, uint8_t startNewRingBuffer);
 
+/**
+ * @brief Add a new variable-length sample to the binary ring buffer.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] isOpen Pointer to store the open status of the ring buffer.
+ * @param[out] numCachedSamples Pointer to store the number of cached samples waiting to be written to disk.
+ * @param[out] numDroppedSamples Pointer to store the number of samples that have been discarded because the cache was full.
+ * @param[out] threadError Pointer to store the result of applying the thread options during initialization: zero on success, otherwise the error number of the first operation that failed.
+ * @param[in] sampleData Pointer to the sample data to add. The size must be equal to the sample size specified during initialization.
+ * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+ * @param[in] sampleLength The number of valid bytes of the sample data, values greater than the sample size are limited to the sample size. Ignored unless the ring buffer has been initialized with variableLength, the full sample is written otherwise.
+ */
+void ETFDriver_BinaryRingBufferStepVariableLength(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, uint8_t* sampleData, uint8_t startNewRingBuffer, uint32_t sampleLength);
+
+/**
+ * @brief Add a new sample to the binary ring buffer and get the writer statistics.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] isOpen Pointer to store the open status of the ring buffer.
+ * @param[out] numCachedSamples Pointer to store the number of cached samples waiting to be written to disk.
+ * @param[out] numDroppedSamples Pointer to store the number of samples that have been discarded because the cache was full.
+ * @param[out] threadError Pointer to store the result of applying the thread options during initialization: zero on success, otherwise the error number of the first operation that failed.
+ * @param[out] statistics Array of 10 values to store the writer statistics: throughput in bytes per second, maximum queue depth, mean and maximum latency, mean and maximum batch write duration, mean and maximum flush duration, mean and maximum sync duration. All durations are in seconds.
+ * @param[in] sampleData Pointer to the sample data to add. The size must be equal to the sample size specified during initialization.
+ * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+ */
+void ETFDriver_BinaryRingBufferStepStatistics(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, double* statistics, uint8_t* sampleData, uint8_t startNewRingBuffer);
+
+/**
+ * @brief Add a new variable-length sample to the binary ring buffer and get the writer statistics.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] isOpen Pointer to store the open status of the ring buffer.
+ * @param[out] numCachedSamples Pointer to store the number of cached samples waiting to be written to disk.
+ * @param[out] numDroppedSamples Pointer to store the number of samples that have been discarded because the cache was full.
+ * @param[out] threadError Pointer to store the result of applying the thread options during initialization: zero on success, otherwise the error number of the first operation that failed.
+ * @param[out] statistics Array of 10 values to store the writer statistics, see @ref ETFDriver_BinaryRingBufferStepStatistics.
+ * @param[in] sampleData Pointer to the sample data to add. The size must be equal to the sample size specified during initialization.
+ * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+ * @param[in] sampleLength The number of valid bytes of the sample data, see @ref ETFDriver_BinaryRingBufferStepVariableLength.
+ */
+void ETFDriver_BinaryRingBufferStepVariableLengthStatistics(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, double* statistics, uint8_t* sampleData, uint8_t startNewRingBuffer, uint32_t sampleLength);
+
+/**
+ * @brief Reserve the next free slot of the binary ring buffer so that the caller can write a sample in place.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] sampleData Pointer to store the address of the slot memory of sample size bytes, nullptr if the sample has been discarded because the cache was full.
+ * @details This is the zero-copy variant of @ref ETFDriver_BinaryRingBufferStep for hand-written code that can produce the sample directly into the cache. The sample must be published by @ref ETFDriver_BinaryRingBufferCommit.
+ */
+void ETFDriver_BinaryRingBufferReserve(void* workVector, void** sampleData);
+
+/**
+ * @brief Publish the sample that has been written to the slot returned by @ref ETFDriver_BinaryRingBufferReserve.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] isOpen Pointer to store the open status of the ring buffer.
+ * @param[out] numCachedSamples Pointer to store the number of cached samples waiting to be written to disk.
+ * @param[out] numDroppedSamples Pointer to store the number of samples that have been discarded because the cache was full.
+ * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+ * @param[in] sampleLength The number of valid bytes that have been written to the slot. Ignored unless the ring buffer has been initialized with variableLength.
+ */
+void ETFDriver_BinaryRingBufferCommit(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, uint8_t startNewRingBuffer, uint32_t sampleLength);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+
+#ifdef __cplusplus
+/* Fixed-size variants for generated C++ code, the generated code of each fixed-length block calls them with the sample
+ * size of that block, see etf.BuildDrivers. */
+#include <etf_binary_ring_buffer.hpp>
+
+
+/**
+ * @brief Apply all parameters of @ref ETFDriver_BinaryRingBufferInitialize to a driver object and initialize it.
+ * @param[in] driver The driver object to be initialized.
+ * @details See @ref ETFDriver_BinaryRingBufferInitialize for a description of all other parameters.
+ */
+void ETFDriver_BinaryRingBufferSetup(etf::BinaryRingBuffer* driver, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority, uint32_t maxNumCachedSamples, uint8_t overflowPolicy, uint32_t overflowTimeoutUs, uint32_t statisticsPeriodMs, uint32_t writerGroup, uint32_t numWriterThreads, uint8_t threadPolicy, uint32_t* threadCpus, uint32_t numThreadCpus, uint32_t notifyWatermark, uint32_t maxNotifyLatencyUs, uint8_t variableLength, uint8_t durability, uint32_t syncPeriodMs, uint8_t backend, uint8_t preallocate, uint32_t flushBytes, uint32_t flushPeriodMs, uint32_t asyncNumBuffers, uint32_t asyncBufferSize, uint8_t codec, uint32_t blockNumSamples, uint8_t filter, uint32_t keyframeInterval, uint32_t journalIntervalSamples, uint32_t syncBytes, uint32_t timeIndexIntervalSamples);
+
+/**
+ * @brief Initialize a binary ring buffer with a sample size that is known at compile time.
+ * @tparam SampleSize Number of bytes per sample, must be equal to sampleSize.
+ * @details Same as @ref ETFDriver_BinaryRingBufferInitialize, but the work vector points to an
+ * etf::FixedSizeBinaryRingBuffer<SampleSize> that copies and writes all samples with a constant size. The work vector must
+ * only be passed to the fixed-size functions with the same SampleSize.
+ */
+template <size_t SampleSize> void ETFDriver_BinaryRingBufferInitializeFixedSize(void** workVector, uint8_t* folderName, uint32_t strlenFolderName, uint32_t sampleSize, uint32_t numSamplesPerFile, uint32_t numFiles, int32_t threadPriority, uint32_t maxNumCachedSamples, uint8_t overflowPolicy, uint32_t overflowTimeoutUs, uint32_t statisticsPeriodMs, uint32_t writerGroup, uint32_t numWriterThreads, uint8_t threadPolicy, uint32_t* threadCpus, uint32_t numThreadCpus, uint32_t notifyWatermark, uint32_t maxNotifyLatencyUs, uint8_t variableLength, uint8_t durability, uint32_t syncPeriodMs, uint8_t backend, uint8_t preallocate, uint32_t flushBytes, uint32_t flushPeriodMs, uint32_t asyncNumBuffers, uint32_t asyncBufferSize, uint8_t codec, uint32_t blockNumSamples, uint8_t filter, uint32_t keyframeInterval, uint32_t journalIntervalSamples, uint32_t syncBytes, uint32_t timeIndexIntervalSamples){
+    etf::FixedSizeBinaryRingBuffer<SampleSize>* driver = new etf::FixedSizeBinaryRingBuffer<SampleSize>();
+    ETFDriver_BinaryRingBufferSetup(driver, folderName, strlenFolderName, sampleSize, numSamplesPerFile, numFiles, threadPriority, maxNumCachedSamples, overflowPolicy, overflowTimeoutUs, statisticsPeriodMs, writerGroup, numWriterThreads, threadPolicy, threadCpus, numThreadCpus, notifyWatermark, maxNotifyLatencyUs, variableLength, durability, syncPeriodMs, backend, preallocate, flushBytes, flushPeriodMs, asyncNumBuffers, asyncBufferSize, codec, blockNumSamples, filter, keyframeInterval, journalIntervalSamples, syncBytes, timeIndexIntervalSamples);
+    *workVector = reinterpret_cast<void*>(driver);
+}
+
+/**
+ * @brief Terminate a binary ring buffer that has been initialized by @ref ETFDriver_BinaryRingBufferInitializeFixedSize.
+ * @tparam SampleSize Number of bytes per sample.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ */
+template <size_t SampleSize> void ETFDriver_BinaryRingBufferTerminateFixedSize(void* workVector){
+    etf::FixedSizeBinaryRingBuffer<SampleSize>* driver = reinterpret_cast<etf::FixedSizeBinaryRingBuffer<SampleSize>*>(workVector);
+    driver->Terminate();
+    delete driver;
+}
+
+/**
+ * @brief Add a new sample to a binary ring buffer that has been initialized by @ref ETFDriver_BinaryRingBufferInitializeFixedSize.
+ * @tparam SampleSize Number of bytes per sample.
+ * @details See @ref ETFDriver_BinaryRingBufferStep for a description of all parameters.
+ */
+template <size_t SampleSize> void ETFDriver_BinaryRingBufferStepFixedSize(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, uint8_t* sampleData, uint8_t startNewRingBuffer){
+    etf::FixedSizeBinaryRingBuffer<SampleSize>* driver = reinterpret_cast<etf::FixedSizeBinaryRingBuffer<SampleSize>*>(workVector);
+    *isOpen = static_cast<uint8_t>(driver->IsOpen());
+    *numCachedSamples = driver->AddSample(sampleData, static_cast<bool>(startNewRingBuffer));
+    *numDroppedSamples = static_cast<uint32_t>(driver->GetNumDroppedSamples());
+    *threadError = static_cast<int32_t>(driver->GetThreadError());
+}
+
+/**
+ * @brief Add a new sample to a binary ring buffer that has been initialized by @ref ETFDriver_BinaryRingBufferInitializeFixedSize and get the writer statistics.
+ * @tparam SampleSize Number of bytes per sample.
+ * @details See @ref ETFDriver_BinaryRingBufferStepStatistics for a description of all parameters.
+ */
+template <size_t SampleSize> void ETFDriver_BinaryRingBufferStepStatisticsFixedSize(void* workVector, uint8_t* isOpen, uint32_t* numCachedSamples, uint32_t* numDroppedSamples, int32_t* threadError, double* statistics, uint8_t* sampleData, uint8_t startNewRingBuffer){
+    ETFDriver_BinaryRingBufferStepFixedSize<SampleSize>(workVector, isOpen, numCachedSamples, numDroppedSamples, threadError, sampleData, startNewRingBuffer);
+    reinterpret_cast<etf::FixedSizeBinaryRingBuffer<SampleSize>*>(workVector)->GetStatistics(statistics);
+}
+#endif
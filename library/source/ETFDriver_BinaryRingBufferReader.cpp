@@ -0,0 +1,27 @@
+#include <ETFDriver_BinaryRingBufferReader.hpp>
+#include <etf_binary_ring_buffer_reader.hpp>
+#include <string>
+
+
+void ETFDriver_BinaryRingBufferReaderInitialize(void** workVector, uint8_t* directoryName, uint32_t strlenDirectoryName, uint32_t maxNumCachedSamples, uint8_t loop, int32_t threadPriority, uint8_t threadPolicy){
+    etf::BinaryRingBufferReader* driver = new etf::BinaryRingBufferReader();
+    std::string directory((char*)directoryName, strlenDirectoryName);
+    etf::detail::ThreadOptions threadOptions;
+    threadOptions.policy = static_cast<etf::detail::ThreadPolicy>(threadPolicy);
+    threadOptions.priority = threadPriority;
+    driver->Initialize(directory.c_str(), maxNumCachedSamples, static_cast<bool>(loop), threadOptions);
+    *workVector = reinterpret_cast<void*>(driver);
+}
+
+void ETFDriver_BinaryRingBufferReaderTerminate(void* workVector){
+    etf::BinaryRingBufferReader* driver = reinterpret_cast<etf::BinaryRingBufferReader*>(workVector);
+    driver->Terminate();
+    delete driver;
+}
+
+void ETFDriver_BinaryRingBufferReaderStep(void* workVector, uint8_t* sampleData, uint32_t* length, uint8_t* endOfData, uint32_t* numUnderruns, uint32_t maxNumBytes){
+    etf::BinaryRingBufferReader* driver = reinterpret_cast<etf::BinaryRingBufferReader*>(workVector);
+    *length = driver->ReadSample(sampleData, maxNumBytes);
+    *endOfData = static_cast<uint8_t>(driver->IsEndOfData());
+    *numUnderruns = static_cast<uint32_t>(driver->GetNumUnderruns());
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif
+
+
+/**
+ * @brief Initialize the binary ring buffer reader and prefetch the first samples.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[in] directoryName Path to a completed ring buffer directory that contains the "complete.json" file.
+ * @param[in] strlenDirectoryName The length of the directory name.
+ * @param[in] maxNumCachedSamples The maximum number of samples to be prefetched by the reader thread. Zero selects a default value.
+ * @param[in] loop Non-zero to restart the replay with the oldest sample after the newest sample has been output.
+ * @param[in] threadPriority The priority of the reader thread.
+ * @param[in] threadPolicy The scheduling policy of the reader thread: 0 (SCHED_FIFO), 1 (SCHED_RR), 2 (SCHED_OTHER, the thread priority is used as nice value).
+ */
+void ETFDriver_BinaryRingBufferReaderInitialize(void** workVector, uint8_t* directoryName, uint32_t strlenDirectoryName, uint32_t maxNumCachedSamples, uint8_t loop, int32_t threadPriority, uint8_t threadPolicy);
+
+/**
+ * @brief Terminate the binary ring buffer reader.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ */
+void ETFDriver_BinaryRingBufferReaderTerminate(void* workVector);
+
+/**
+ * @brief Output the next recorded sample.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] sampleData Output array, where to store the sample.
+ * @param[out] length Output where to store the number of valid bytes of the sample. Zero if no sample is available in this step.
+ * @param[out] endOfData Output where to store whether all samples have been output.
+ * @param[out] numUnderruns Output where to store the number of steps without a sample because the reader thread did not prefetch in time.
+ * @param[in] maxNumBytes Maximum number of bytes that fit into the output array.
+ */
+void ETFDriver_BinaryRingBufferReaderStep(void* workVector, uint8_t* sampleData, uint32_t* length, uint8_t* endOfData, uint32_t* numUnderruns, uint32_t maxNumBytes);
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
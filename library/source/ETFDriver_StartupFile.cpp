@@ -3,10 +3,17 @@
 #include <string>
 
 
-void ETFDriver_StartupFileInitialize(void** workVector, uint8_t* filename, uint32_t strlenFilename, uint32_t maxNumBytes){
+void ETFDriver_StartupFileInitialize(void** workVector, uint8_t* filename, uint32_t strlenFilename, uint32_t maxNumBytes, uint8_t memoryMapped, uint8_t lockMemory, uint8_t streaming, uint32_t streamChunkSize, uint8_t asynchronous, uint8_t shared){
     etf::StartupFile* driver = new etf::StartupFile();
     std::string file((char*)filename, strlenFilename);
-    driver->Initialize(file.c_str(), maxNumBytes);
+    etf::StartupFileOptions options;
+    options.memory_mapped = static_cast<bool>(memoryMapped);
+    options.lock_memory = static_cast<bool>(lockMemory);
+    options.streaming = static_cast<bool>(streaming);
+    options.stream_chunk_size = streamChunkSize;
+    options.asynchronous = static_cast<bool>(asynchronous);
+    options.shared = static_cast<bool>(shared);
+    driver->Initialize(file.c_str(), maxNumBytes, options);
     *workVector = reinterpret_cast<void*>(driver);
 }
 
@@ -16,8 +23,15 @@ void ETFDriver_StartupFileTerminate(void* workVector){
     delete driver;
 }
 
-void ETFDriver_StartupFileStep(void* workVector, uint8_t* bytes, uint32_t* length, uint32_t maxNumBytes){
+void ETFDriver_StartupFileStep(void* workVector, uint8_t* bytes, uint32_t* length, uint8_t* changed, uint8_t* ready, uint32_t maxNumBytes, uint8_t copyOnce){
     etf::StartupFile* driver = reinterpret_cast<etf::StartupFile*>(workVector);
-    driver->GetBytes(bytes, length, maxNumBytes);
+    *changed = static_cast<uint8_t>(driver->GetBytes(bytes, length, maxNumBytes, static_cast<bool>(copyOnce)));
+    *ready = static_cast<uint8_t>(driver->IsReady());
 }
 
+
+void ETFDriver_StartupFileGetData(void* workVector, const uint8_t** data, uint32_t* length){
+    etf::StartupFile* driver = reinterpret_cast<etf::StartupFile*>(workVector);
+    *data = driver->GetData();
+    *length = driver->GetLength();
+}
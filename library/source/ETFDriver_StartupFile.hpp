@@ -1,7 +1,12 @@
 #pragma once
 
 
+#ifdef __cplusplus
 #include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif
 
 
 /**
@@ -10,8 +15,14 @@
  * @param[in] filename Absolute path to the startup file.
  * @param[in] strlenFilename The length of the filename.
  * @param[in] maxNumBytes Maximum number of bytes to read from the file.
+ * @param[in] memoryMapped Non-zero to map the file read-only into memory instead of reading it into a buffer.
+ * @param[in] lockMemory Non-zero to prefault and lock all pages of the mapping, such that no page faults occur during execution.
+ * @param[in] streaming Non-zero to output the file as a sequence of slices of maxNumBytes bytes, one slice per step. The file size is not limited and a background thread prefetches the file in chunks.
+ * @param[in] streamChunkSize Number of bytes that are prefetched at once into each of the two chunk buffers. Zero selects one slice.
+ * @param[in] asynchronous Non-zero to load the file by a background thread, such that the start function of the model does not block. Use the ready output of the step to gate on the data.
+ * @param[in] shared Non-zero to share the binary data read-only with all other startup file blocks that load the same unmodified file with the same maxNumBytes, such that the file is read and stored only once.
  */
-void ETFDriver_StartupFileInitialize(void** workVector, uint8_t* filename, uint32_t strlenFilename, uint32_t maxNumBytes);
+void ETFDriver_StartupFileInitialize(void** workVector, uint8_t* filename, uint32_t strlenFilename, uint32_t maxNumBytes, uint8_t memoryMapped, uint8_t lockMemory, uint8_t streaming, uint32_t streamChunkSize, uint8_t asynchronous, uint8_t shared);
 
 /**
  * @brief Terminate the startup file.
@@ -23,8 +34,25 @@ void ETFDriver_StartupFileTerminate(void* workVector);
  * @brief Get binary data from the startup file.
  * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
  * @param[out] bytes Output array, where to store the binary data.
- * @param[out] length Output where to store the number of bytes that represent the actual binary data.
+ * @param[out] length Output where to store the number of bytes that represent the actual binary data. In streaming mode, this is zero at the end of the file or if the next slice has not been prefetched in time.
+ * @param[out] changed Output where to store whether the binary data changed since the previous step (one for the first step), such that downstream blocks can skip their work otherwise.
+ * @param[out] ready Output where to store whether the binary data has been loaded. The length is zero until the data is ready.
  * @param[in] maxNumBytes Maximum number of bytes that fit into the output array.
+ * @param[in] copyOnce Non-zero to copy the binary data only if it changed or the output array moved. The output signal must not be reused by other blocks.
+ */
+void ETFDriver_StartupFileStep(void* workVector, uint8_t* bytes, uint32_t* length, uint8_t* changed, uint8_t* ready, uint32_t maxNumBytes, uint8_t copyOnce);
+
+
+/**
+ * @brief Get the binary data of the startup file without copying.
+ * @param[in] workVector The simulink work vector storing the pointer to the actual driver object.
+ * @param[out] data Pointer to store the address of the binary data, nullptr if no data is available. The address remains valid until the startup file is terminated.
+ * @param[out] length Output where to store the number of bytes that represent the actual binary data.
+ * @details This function is intended for hand-written code that processes the data in place.
  */
-void ETFDriver_StartupFileStep(void* workVector, uint8_t* bytes, uint32_t* length, uint32_t maxNumBytes);
+void ETFDriver_StartupFileGetData(void* workVector, const uint8_t** data, uint32_t* length);
+
 
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
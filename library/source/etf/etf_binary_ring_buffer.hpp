@@ -13,11 +13,22 @@
 #include <cstdio>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+#include <cstdlib>
 #include <vector>
+#include <array>
 #include <filesystem>
-#include <mutex>
 #include <string>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <semaphore>
+#include <cerrno>
+#include <signal.h>
+#include <unistd.h>
 #include <etf_detail.hpp>
 
 
@@ -25,22 +36,33 @@
 namespace etf {
 
 
+/**
+ * @brief Policy that defines how a binary ring buffer handles a new sample if the cache is full.
+ */
+enum class OverflowPolicy : uint8_t {
+    drop_newest = 0,                      // The new sample is discarded.
+    drop_oldest = 1,                      // The oldest cached sample is discarded. If the worker thread is currently writing the oldest samples, the new sample is discarded instead.
+    block = 2                             // Wait until the worker thread has made room for the new sample. The new sample is discarded if the timeout expires.
+};
+
+
 /**
  * @brief Ring buffer for storing binary data samples in a non-blocking manner. All incoming samples are stored
  * in memory and written to disk by a worker thread. The ring buffer can be re-initialized at any time to start a new
  * ring buffer. All data files are stored in a specified folder, with each ring buffer instance creating a new subfolder
- * named according to the current UTC time.
+ * named according to the current UTC time. A housekeeping thread opens the next ring buffer in advance and closes
+ * retired ring buffers, such that starting a new ring buffer does not stall the worker thread.
  */
 class BinaryRingBuffer {
     public:
         /**
          * @brief Construct a new binary ring buffer object.
          */
-        BinaryRingBuffer(): sample_size(0), num_samples_per_file(0), num_files(0), ring_counter(0) {}
+        BinaryRingBuffer(): write_samples(&detail::MultiFileRingBuffer::Write), sample_size(0), num_samples_per_file(0), num_files(0), ring_counter(0), pending_counter(0), overflow_policy(OverflowPolicy::drop_newest), overflow_timeout(0), num_dropped_samples(0), reserved_slot(nullptr), statistics_period(0), is_open(false), statistics_requested(false), writer_channel(nullptr), thread_error(0), notify_watermark(1), notify_period(0), room_requested(false), semRoom(0) {}
 
         /**
          * @brief Destroy the binary ring buffer object.
-         * @details Stops the worker thread, closes the ring buffer, and clears all stored chunks.
+         * @details Stops the worker thread, closes the ring buffer, and clears all cached samples.
          */
         ~BinaryRingBuffer(){ Terminate(); }
 
@@ -50,38 +72,105 @@ class BinaryRingBuffer {
          * @param[in] sampleSize Size of each sample in bytes.
          * @param[in] numSamplesPerFile Number of samples to store in each file.
          * @param[in] numFiles Number of files to use for the ring buffer.
-         * @param[in] threadPriority Priority of the worker thread.
+         * @param[in] threadPriority Priority of the worker thread and the housekeeping thread, replaces the priority of the
+         * thread options set by @ref SetThreadOptions. Ignored if a writer service is used.
+         * @param[in] maxNumCachedSamples Maximum number of samples to be cached in memory. The memory for all cached samples is
+         * preallocated and @ref AddSample does not allocate any heap memory. If this value is zero, @ref default_max_num_cached_samples is used.
+         * @param[in] overflowPolicy Policy that defines how new samples are handled if the cache is full.
+         * @param[in] overflowTimeoutUs Maximum time in microseconds to wait for room in the cache if the overflow policy is @ref OverflowPolicy::block.
+         * @param[in] statisticsPeriodMs Period in milliseconds for writing a "statistics.json" file to the directory of the active
+         * ring buffer. The file is also written when a ring buffer is closed. Zero disables the statistics file.
+         * @param[in] fileOptions Options for the files of the ring buffer, e.g. the flush policy.
+         * @details If the ring buffer is already initialized, it is terminated first. The writer service, the thread options
+         * and the wakeup coalescing policy that have been set for this initialization are kept.
          */
-        void Initialize(const char* folder, size_t sampleSize, size_t numSamplesPerFile, size_t numFiles, int threadPriority){
+        void Initialize(const char* folder, size_t sampleSize, size_t numSamplesPerFile, size_t numFiles, int threadPriority, size_t maxNumCachedSamples = 0, OverflowPolicy overflowPolicy = OverflowPolicy::drop_newest, uint32_t overflowTimeoutUs = 0, uint32_t statisticsPeriodMs = 0, const detail::MultiFileRingBufferOptions& fileOptions = detail::MultiFileRingBufferOptions()){
+            Close();
             data_folder = std::filesystem::path(folder);
+            RemovePendingDirectories();
+            file_options = fileOptions;
+            overflow_policy = overflowPolicy;
+            overflow_timeout = std::chrono::microseconds(overflowTimeoutUs);
+            num_dropped_samples = 0;
+            reserved_slot = nullptr;
+            statistics.Reset();
+            statistics_period = std::chrono::milliseconds(statisticsPeriodMs);
+            time_of_statistics = std::chrono::steady_clock::now();
+            statistics_requested = false;
             sample_size = sampleSize ? sampleSize : 1;
             num_samples_per_file = numSamplesPerFile ? numSamplesPerFile : 1;
             num_files = numFiles ? numFiles : 1;
-            thread.Start(std::bind(&BinaryRingBuffer::CallbackNotify, this), threadPriority);
+            queue.Resize(sample_size, maxNumCachedSamples ? maxNumCachedSamples : default_max_num_cached_samples);
+            bool periodic = writer_service ? writer_service->IsPeriodic() : (notify_period.count() > 0);
+            notify_watermark = periodic ? std::clamp<size_t>(notify_watermark, 1, queue.Capacity()) : 1;
+            ringBuffer = std::make_unique<detail::MultiFileRingBuffer>();
+            if(writer_service){
+                writer_channel = writer_service->Register(std::bind(&BinaryRingBuffer::CallbackNotify, this), std::bind(&BinaryRingBuffer::CallbackHousekeeping, this), std::bind(&BinaryRingBuffer::IsWriteDue, this));
+                thread_error = writer_service->GetStartError();
+            }
+            else{
+                detail::ThreadOptions options = thread_options;
+                options.priority = threadPriority;
+                thread_error = housekeepingThread.Start(std::bind(&BinaryRingBuffer::CallbackHousekeeping, this), options);
+                int err = thread.Start(std::bind(&BinaryRingBuffer::CallbackNotify, this), options, notify_period);
+                thread_error = thread_error ? thread_error : err;
+            }
+            NotifyHousekeeping(); // open first ring buffer in advance
+        }
+
+        /**
+         * @brief Use a shared writer service instead of a dedicated worker thread and housekeeping thread.
+         * @param[in] service The writer service to be used by the next call to @ref Initialize. Several binary ring buffers
+         * may share the same service. If this is a nullptr, dedicated threads are used.
+         * @details Must be called before @ref Initialize. @ref Terminate resets the writer service.
+         */
+        void SetWriterService(std::shared_ptr<detail::WriterService> service){ writer_service = service; }
+
+        /**
+         * @brief Set the scheduling policy and the CPU affinity of the worker thread and the housekeeping thread.
+         * @param[in] options Thread options to be used by the next call to @ref Initialize. The priority is replaced by the
+         * thread priority passed to @ref Initialize.
+         * @details Must be called before @ref Initialize. @ref Terminate resets the thread options. Pin the threads to CPUs other than the one that runs the real-time
+         * model step to reduce jitter. Use @ref GetThreadError to check whether the options have been applied.
+         */
+        void SetThreadOptions(const detail::ThreadOptions& options){ thread_options = options; }
+
+        /**
+         * @brief Get the result of applying the thread options during initialization.
+         * @return Zero if the options have been applied to all threads, otherwise the error number of the first operation
+         * that failed (e.g. EPERM if the process is not allowed to use a real-time policy).
+         */
+        int GetThreadError(void) const { return thread_error; }
+
+        /**
+         * @brief Set the wakeup coalescing policy of the worker thread.
+         * @param[in] watermark The worker thread is only notified if at least this number of samples is cached.
+         * @param[in] maxLatencyUs Maximum time in microseconds between two wakeups of the worker thread. If this is zero, the
+         * worker thread is notified after each sample and the watermark is ignored.
+         * @details Must be called before @ref Initialize. @ref Terminate resets the policy. Notifying less often reduces the
+         * wakeups of the worker thread and the futex traffic of the model step and increases the size of each drained
+         * batch. Samples stay in the cache for at most maxLatencyUs before the worker thread starts to write them. If a
+         * writer service is used, the wakeup period is given by the service and the watermark is only used if the service
+         * wakes up periodically.
+         * The blocking overflow policy always notifies the worker thread.
+         */
+        void SetWakeupCoalescing(size_t watermark, uint32_t maxLatencyUs){
+            notify_watermark = watermark;
+            notify_period = std::chrono::microseconds(maxLatencyUs);
         }
 
         /**
          * @brief Terminate the binary ring buffer.
-         * @details Stops the worker thread, closes the ring buffer, and clears all stored chunks.
+         * @details Stops the worker thread, closes the ring buffer, and clears all cached samples.
          */
         void Terminate(void){
-            // stop thread and write all remaining chunks
-            thread.Stop();
-            mtxChunks.lock();
-            if(!chunks.empty()){ // prevents opening a new ring buffer if there are no chunks
-                WriteChunks(chunks);
-            }
-            chunks.clear();
-            mtxChunks.unlock();
+            Close();
 
-            // close ring buffer
-            ringBuffer.Close();
-
-            // set parameters to default values (except ring counter)
-            sample_size = 0;
-            num_samples_per_file = 0;
-            num_files = 0;
-            data_folder.clear();
+            // reset the settings for the next initialization
+            writer_service.reset();
+            thread_options = detail::ThreadOptions();
+            notify_watermark = 1;
+            notify_period = std::chrono::microseconds(0);
         }
 
         /**
@@ -89,53 +178,394 @@ class BinaryRingBuffer {
          * @param[in] sampleData Pointer to the sample data to add. The size must be equal to the sample size specified during initialization.
          * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
          * @return The number of cached samples waiting to be written to disk.
+         * @details This function does not take any lock. If the cache is full, the sample is handled according to the overflow
+         * policy. Only the @ref OverflowPolicy::block policy may wait for the worker thread.
          */
-        uint32_t AddSample(const void* sampleData, bool startNewRingBuffer){
-            mtxChunks.lock();
-            chunks.push_back({std::vector<uint8_t>((uint8_t*)sampleData, (uint8_t*)sampleData + sample_size), startNewRingBuffer});
-            uint32_t numCachedChunks = static_cast<uint32_t>(chunks.size());
-            mtxChunks.unlock();
-            thread.Notify();
-            return numCachedChunks;
+        uint32_t AddSample(const void* sampleData, bool startNewRingBuffer){ return AddSample(sampleData, sample_size, startNewRingBuffer); }
+
+        /**
+         * @brief Add a new variable-length sample to the binary ring buffer.
+         * @param[in] sampleData Pointer to the sample data to add.
+         * @param[in] length Number of valid bytes of the sample data. Values greater than the sample size specified during
+         * initialization are limited to the sample size.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @return The number of cached samples waiting to be written to disk.
+         * @details If the ring buffer has been initialized with the variable-length file option, only the valid bytes are
+         * copied into the cache and written to disk. Otherwise the length is ignored and the sample data must provide the
+         * full sample size, such that no stale bytes of a previous sample are written.
+         */
+        uint32_t AddSample(const void* sampleData, size_t length, bool startNewRingBuffer){
+            length = (file_options.variable_length && (length < sample_size)) ? length : sample_size;
+            uint8_t* slot = ReserveSlot();
+            if(slot){
+                std::memcpy(slot, sampleData, length);
+                queue.Commit(startNewRingBuffer, Now(), static_cast<uint32_t>(length));
+            }
+            reserved_slot = nullptr;
+            return PublishSample();
+        }
+
+        /**
+         * @brief Reserve the next free slot of the cache so that the caller can write a sample in place.
+         * @return Pointer to the slot memory of the sample size specified during initialization or nullptr if the sample
+         * has been discarded according to the overflow policy.
+         * @details This is the zero-copy variant of @ref AddSample. The caller writes the sample directly into the returned
+         * slot and publishes it by @ref CommitSample. The worker thread writes the sample from the same memory to the file.
+         * If the cache is full, the overflow policy is applied in the same way as for @ref AddSample. Calling this function
+         * again before @ref CommitSample returns the same slot.
+         */
+        void* ReserveSample(void){
+            if(!reserved_slot){
+                reserved_slot = ReserveSlot();
+            }
+            return reserved_slot;
+        }
+
+        /**
+         * @brief Publish the sample that has been written to the slot returned by @ref ReserveSample.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @return The number of cached samples waiting to be written to disk.
+         * @details If no slot has been reserved, e.g. because the sample has been discarded, nothing is published.
+         */
+        uint32_t CommitSample(bool startNewRingBuffer){ return CommitSample(startNewRingBuffer, sample_size); }
+
+        /**
+         * @brief Publish a variable-length sample that has been written to the slot returned by @ref ReserveSample.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @param[in] length Number of valid bytes at the beginning of the slot. Values greater than the sample size are
+         * limited to the sample size. Ignored unless the ring buffer has been initialized with the variable-length file
+         * option, the full slot is written otherwise.
+         * @return The number of cached samples waiting to be written to disk.
+         */
+        uint32_t CommitSample(bool startNewRingBuffer, size_t length){
+            if(reserved_slot){
+                length = (file_options.variable_length && (length < sample_size)) ? length : sample_size;
+                queue.Commit(startNewRingBuffer, Now(), static_cast<uint32_t>(length));
+                reserved_slot = nullptr;
+            }
+            return PublishSample();
         }
 
+        /**
+         * @brief Get the sample size that has been specified during initialization.
+         * @return Number of bytes per sample, zero if the ring buffer has not been initialized.
+         */
+        size_t GetSampleSize(void) const { return sample_size; }
+
         /**
          * @brief Check if the ring buffer is currently open.
          * @return True if the ring buffer is open, false otherwise.
-         * @note This is not thread-safe but it's fine for monitoring.
          */
-        bool IsOpen(void) const { return ringBuffer.IsOpen(); }
+        bool IsOpen(void) const { return is_open; }
 
-    private:
-        struct chunk_data {
-            std::vector<uint8_t> data;            // Actual sample data of size @ref sample_size.
-            bool start_new_ring_buffer;           // Flag indicating whether to start a new ring buffer before writing this sample.
-        };
+        /**
+         * @brief Get the number of samples that have been discarded because the cache was full.
+         * @return The number of discarded samples since the last initialization.
+         * @note This must be called from the same thread as @ref AddSample.
+         */
+        size_t GetNumDroppedSamples(void) const { return num_dropped_samples; }
+
+        /**
+         * @brief Get a summary of the writer statistics.
+         * @param[out] values Array of @ref detail::WriterStatistics::num_summary_values values, see @ref detail::WriterStatistics::GetSummary.
+         * @details This function does not take any lock and can be called from any thread.
+         */
+        void GetStatistics(double* values) const { statistics.GetSummary(values); }
 
+        /**
+         * @brief Default maximum number of samples to be cached in memory if no value is specified during initialization.
+         */
+        static constexpr size_t default_max_num_cached_samples = 4096;
+
+    protected:
+        /**
+         * @brief Add a new sample of a sample size that is known at compile time.
+         * @tparam SampleSize Number of bytes to copy, must not exceed the sample size specified during initialization.
+         * @param[in] sampleData Pointer to the sample data to add.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @return The number of cached samples waiting to be written to disk.
+         * @details Same as @ref AddSample, but the copy into the cache has a constant size and is inlined by the compiler.
+         */
+        template <size_t SampleSize> uint32_t AddFixedSizeSample(const void* sampleData, bool startNewRingBuffer){
+            uint8_t* slot = ReserveSlot();
+            if(slot){
+                std::memcpy(slot, sampleData, SampleSize);
+                queue.Commit(startNewRingBuffer, Now(), static_cast<uint32_t>(SampleSize));
+            }
+            reserved_slot = nullptr;
+            return PublishSample();
+        }
+
+        void (detail::MultiFileRingBuffer::*write_samples)(const void*, size_t, const uint64_t*); // Function of the multi-file ring buffer that writes a batch of fixed-length samples, worker thread only.
+
+    private:
         size_t sample_size;                       // Size of each sample in the ring buffer.
         size_t num_samples_per_file;              // Number of samples per file in the ring buffer.
         size_t num_files;                         // Number of files in the ring buffer.
         size_t ring_counter;                      // Counter for the number of ring buffers created.
+        size_t pending_counter;                   // Counter for the temporary names of ring buffers that are opened in advance, housekeeping only.
+        OverflowPolicy overflow_policy;           // Policy for handling new samples if the cache is full.
+        std::chrono::microseconds overflow_timeout; // Timeout for the blocking overflow policy.
+        size_t num_dropped_samples;               // Number of discarded samples, only accessed by the thread that calls @ref AddSample.
+        uint8_t* reserved_slot;                   // Queue slot returned by @ref ReserveSample that has not been committed yet, producer only.
+        std::chrono::milliseconds statistics_period; // Period for writing the statistics file, zero if disabled.
+        std::chrono::steady_clock::time_point time_of_statistics; // Time when the statistics file has been requested the last time, worker thread only.
+        detail::WriterStatistics statistics;      // Latency and throughput statistics of this ring buffer.
         std::filesystem::path data_folder;        // Data folder path where to store files for ring buffers.
-        detail::MultiFileRingBuffer ringBuffer;   // Manages a multi-file ring buffer.
+        detail::MultiFileRingBufferOptions file_options; // Options for opening the multi-file ring buffer.
+        std::unique_ptr<detail::MultiFileRingBuffer> ringBuffer; // The active multi-file ring buffer, only accessed by the worker thread.
+        std::unique_ptr<detail::MultiFileRingBuffer> nextRingBuffer; // Ring buffer opened in advance by the housekeeping thread, protected by @ref mtxRotation.
+        std::vector<std::unique_ptr<detail::MultiFileRingBuffer>> retiredRingBuffers; // Ring buffers to be closed by the housekeeping thread, protected by @ref mtxRotation.
+        std::mutex mtxRotation;                   // Mutex for protecting access to @ref nextRingBuffer and @ref retiredRingBuffers.
+        std::filesystem::path active_directory;   // Directory of the active ring buffer, protected by @ref mtxRotation.
+        std::atomic<bool> is_open;                // True if the active ring buffer is open.
+        std::atomic<bool> statistics_requested;   // True if the housekeeping thread should write the statistics file.
         detail::NotifyableThread thread;          // Worker thread that is notified when new samples are available.
-        std::vector<chunk_data> chunks;           // Storage for chunks of sample data to be written to the ring buffer.
-        std::mutex mtxChunks;                     // Mutex for protecting access to @ref chunks.
+        detail::NotifyableThread housekeepingThread; // Thread that opens the next ring buffer in advance and closes retired ring buffers.
+        std::shared_ptr<detail::WriterService> writer_service; // Shared writer service that replaces both threads if not nullptr.
+        detail::WriterService::channel* writer_channel; // Channel of this ring buffer while registered to @ref writer_service.
+        detail::ThreadOptions thread_options;     // Policy and affinity of the dedicated threads.
+        int thread_error;                         // Result of applying the thread options during initialization.
+        size_t notify_watermark;                  // Minimum number of cached samples for notifying the worker thread.
+        std::chrono::microseconds notify_period;  // Wakeup period of the worker thread, zero if it is only woken up by notifications.
+        detail::SampleQueue queue;                // Preallocated single-producer/single-consumer queue of samples to be written to the ring buffer.
+        std::atomic<bool> room_requested;         // True if the producer waits for room in the queue (blocking overflow policy).
+        std::binary_semaphore semRoom;            // Semaphore that is released by the consumer after a pop if room has been requested.
+
+        /**
+         * @brief Stop all threads, write all remaining samples and close all ring buffers.
+         * @details The settings for the next initialization (writer service, thread options and wakeup coalescing) are kept.
+         */
+        void Close(void){
+            // stop thread and write all remaining samples, this thread is the only consumer from now on
+            if(writer_channel){
+                writer_service->Unregister(writer_channel); // also stops housekeeping for this channel
+                writer_channel = nullptr;
+            }
+            thread.Stop();
+            size_t numSamples = queue.Claim();
+            if(numSamples){ // prevents opening a new ring buffer if there are no samples
+                WriteQueue(numSamples);
+                queue.Pop(numSamples);
+            }
+            queue.Release();
+
+            // close all ring buffers and remove the ring buffer that has been opened in advance
+            housekeepingThread.Stop();
+            std::vector<std::unique_ptr<detail::MultiFileRingBuffer>> retired;
+            std::unique_lock<std::mutex> lock(mtxRotation);
+            retired.swap(retiredRingBuffers);
+            if(nextRingBuffer){
+                nextRingBuffer->Discard();
+                nextRingBuffer.reset();
+            }
+            lock.unlock();
+            if(ringBuffer && ringBuffer->IsOpen()){
+                retired.push_back(std::move(ringBuffer));
+            }
+            CloseRingBuffers(retired);
+            ringBuffer.reset();
+            is_open = false;
+
+            // set parameters to default values (except ring counter)
+            sample_size = 0;
+            num_samples_per_file = 0;
+            num_files = 0;
+            data_folder.clear();
+            active_directory.clear();
+            statistics_period = std::chrono::milliseconds(0);
+            file_options = detail::MultiFileRingBufferOptions();
+            reserved_slot = nullptr; // an uncommitted reservation is discarded
+        }
 
         /**
          * @brief Callback function executed inside the worker thread when notified.
-         * @details Moves all available chunks to local storage of this thread, opens the ring buffer if not already open,
-         * handles new ring buffer requests, and writes sample data to the ring buffer.
+         * @details Writes all samples that are available in the queue to the ring buffer and releases their slots afterwards.
+         * If the queue is empty, a periodic wakeup flushes and synchronizes the ring buffer if due.
          */
         void CallbackNotify(void){
-            // move all available chunks to local storage of this thread
-            std::vector<chunk_data> localChunks;
-            mtxChunks.lock();
-            localChunks.swap(chunks);
-            mtxChunks.unlock();
+            size_t numSamples = queue.Claim();
+            WriteQueue(numSamples);
+            queue.Pop(numSamples);
+            if(numSamples && room_requested.exchange(false)){
+                semRoom.release(); // wake up the producer that waits because of the blocking overflow policy
+            }
+            if(!numSamples && ringBuffer){
+                ringBuffer->FlushIfDue();
+            }
 
-            // write chunk data to ring buffer
-            WriteChunks(localChunks);
+            // request the periodic statistics file from the housekeeping thread
+            if(statistics_period.count()){
+                auto now = std::chrono::steady_clock::now();
+                if((now - time_of_statistics) >= statistics_period){
+                    time_of_statistics = now;
+                    statistics_requested = true;
+                    NotifyHousekeeping();
+                }
+            }
+        }
+
+        /**
+         * @brief Check whether a periodic wakeup of a shared writer service has to execute @ref CallbackNotify.
+         * @return True if samples are cached, a flush or sync of the ring buffer is due or the statistics period has elapsed.
+         * @details Executed inside the worker thread.
+         */
+        bool IsWriteDue(void) const {
+            if(queue.Size() || (ringBuffer && ringBuffer->IsFlushOrSyncDue())){
+                return true;
+            }
+            return statistics_period.count() && ((std::chrono::steady_clock::now() - time_of_statistics) >= statistics_period);
+        }
+
+        /**
+         * @brief Callback function executed inside the housekeeping thread when notified.
+         * @details Closes all retired ring buffers, which writes their "complete.json" files, and opens the next ring buffer in
+         * a temporary directory if there is none. Writes the "statistics.json" file if requested or if a ring buffer is retired.
+         */
+        void CallbackHousekeeping(void){
+            std::vector<std::unique_ptr<detail::MultiFileRingBuffer>> retired;
+            std::unique_lock<std::mutex> lock(mtxRotation);
+            retired.swap(retiredRingBuffers);
+            bool openNext = !nextRingBuffer;
+            std::filesystem::path directory = active_directory;
+            lock.unlock();
+            CloseRingBuffers(retired);
+            if(statistics_period.count() && statistics_requested.exchange(false) && !directory.empty()){
+                statistics.WriteJSON(directory / "statistics.json");
+            }
+            if(openNext){
+                std::unique_ptr<detail::MultiFileRingBuffer> next = std::make_unique<detail::MultiFileRingBuffer>();
+                directory = data_folder / (std::string(pending_prefix) + std::to_string(getpid()) + "_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "_" + std::to_string(++pending_counter));
+                if(next->Open(directory.string().c_str(), sample_size, num_samples_per_file, num_files, file_options)){
+                    lock.lock();
+                    nextRingBuffer.swap(next);
+                    lock.unlock();
+                }
+            }
+        }
+
+        /**
+         * @brief Prefix of the temporary directory names of ring buffers that are opened in advance.
+         * @details The full name is "<prefix><pid>_<instance>_<counter>", such that the names of all binary ring buffers
+         * of all processes are unique and the owning process of a directory can be identified.
+         */
+        static constexpr const char* pending_prefix = ".pending_";
+
+        /**
+         * @brief Remove all stale directories of ring buffers that have been opened in advance but have never been activated.
+         * @details Such directories remain in the data folder if a previous process has been killed. Directories whose owning
+         * process is still running, including this process, are kept, such that the data folder can be shared with other
+         * binary ring buffers that are running.
+         */
+        void RemovePendingDirectories(void){
+            std::vector<std::filesystem::path> pending;
+            std::error_code ec;
+            for(std::filesystem::directory_iterator it(data_folder, ec), end; !ec && (it != end); it.increment(ec)){
+                std::string name = it->path().filename().string();
+                if((0 == name.rfind(pending_prefix, 0)) && IsStalePendingDirectory(name.substr(std::strlen(pending_prefix)))){
+                    pending.push_back(it->path());
+                }
+            }
+            for(auto&& directory : pending){
+                std::filesystem::remove_all(directory, ec);
+            }
+        }
+
+        /**
+         * @brief Check whether a directory that has been opened in advance belongs to a process that no longer exists.
+         * @param[in] suffix Name of the directory without the @ref pending_prefix.
+         * @return True if the owning process does not exist or if the name does not contain a process ID, false otherwise.
+         */
+        static bool IsStalePendingDirectory(const std::string& suffix){
+            std::string digits = suffix.substr(0, suffix.find('_'));
+            if(digits.empty() || (digits.size() == suffix.size()) || (std::string::npos != digits.find_first_not_of("0123456789"))){
+                return true;
+            }
+            pid_t pid = static_cast<pid_t>(std::strtol(digits.c_str(), nullptr, 10));
+            if((pid <= 0) || (pid == getpid())){
+                return pid <= 0;
+            }
+            return (0 != kill(pid, 0)) && (ESRCH == errno);
+        }
+
+        /**
+         * @brief Close ring buffers and write their statistics files.
+         * @param[in] ringBuffers The ring buffers to be closed, the container is cleared.
+         * @details The files are closed before the statistics file is written, such that the statistics include the final
+         * writes, flushes and synchronizations of each ring buffer.
+         */
+        void CloseRingBuffers(std::vector<std::unique_ptr<detail::MultiFileRingBuffer>>& ringBuffers){
+            for(auto&& rb : ringBuffers){
+                std::filesystem::path directory = rb->GetDirectory();
+                rb->Close();
+                if(statistics_period.count() && !directory.empty()){
+                    statistics.WriteJSON(directory / "statistics.json");
+                }
+            }
+            ringBuffers.clear();
+        }
+
+        /**
+         * @brief Reserve the next free slot of the cache and apply the overflow policy if the cache is full.
+         * @return Pointer to the slot memory or nullptr if the new sample has been discarded.
+         */
+        uint8_t* ReserveSlot(void){
+            uint8_t* slot = queue.Reserve();
+            if(slot){
+                return slot;
+            }
+            if(OverflowPolicy::drop_oldest == overflow_policy){
+                if(queue.DropOldest()){
+                    num_dropped_samples++;
+                    if((slot = queue.Reserve())){
+                        return slot;
+                    }
+                }
+            }
+            else if(OverflowPolicy::block == overflow_policy){
+                // wait for the consumer to release slots: both sides modify the request flag by read-modify-write
+                // operations, such that either the consumer sees the request after its pop or the producer sees the
+                // popped slots, and the semaphore is released at most once per request
+                NotifyWriter();
+                auto deadline = std::chrono::steady_clock::now() + overflow_timeout;
+                for(;;){
+                    (void)room_requested.exchange(true);
+                    slot = queue.Reserve();
+                    if(!slot && semRoom.try_acquire_until(deadline)){
+                        continue; // the consumer has popped samples and taken the request
+                    }
+                    if(!room_requested.exchange(false)){
+                        semRoom.acquire(); // the consumer took the request, its release is imminent
+                    }
+                    break;
+                }
+                if(slot || (slot = queue.Reserve())){
+                    return slot;
+                }
+            }
+            num_dropped_samples++;
+            return nullptr;
+        }
+
+        /**
+         * @brief Update the queue depth statistics and notify the worker thread after a sample has been added.
+         * @return The number of cached samples waiting to be written to disk.
+         */
+        uint32_t PublishSample(void){
+            size_t queueDepth = queue.Size();
+            statistics.UpdateQueueDepth(queueDepth);
+            if(queueDepth >= notify_watermark){
+                NotifyWriter();
+            }
+            return static_cast<uint32_t>(queueDepth);
+        }
+
+        /**
+         * @brief Get the current time of the steady clock.
+         * @return Time in nanoseconds since the epoch of the steady clock, used as timestamp for new samples.
+         */
+        static uint64_t Now(void){
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
         }
 
         /**
@@ -145,38 +575,191 @@ class BinaryRingBuffer {
         std::string GenerateSubdirectoryName(void){
             auto timePoint = std::chrono::system_clock::now();
             std::time_t systemTime = std::chrono::system_clock::to_time_t(timePoint);
-            std::tm* gmTime = std::gmtime(&systemTime);
+            std::tm gmTime;
+            gmtime_r(&systemTime, &gmTime); // reentrant, several ring buffers may rotate concurrently
             char cstr_utc[64];
-            snprintf(cstr_utc, sizeof(cstr_utc), "%u%02u%02u_%02u%02u%02u", 1900 + gmTime->tm_year, 1 + gmTime->tm_mon, gmTime->tm_mday, gmTime->tm_hour, gmTime->tm_min, gmTime->tm_sec);
+            snprintf(cstr_utc, sizeof(cstr_utc), "%u%02u%02u_%02u%02u%02u", 1900 + gmTime.tm_year, 1 + gmTime.tm_mon, gmTime.tm_mday, gmTime.tm_hour, gmTime.tm_min, gmTime.tm_sec);
             return std::string(cstr_utc) + std::string("_") + std::string("ring") + std::to_string(ring_counter);
         }
 
         /**
-         * @brief Write chunks of data to the ring buffer.
-         * @param[in] dataChunks The chunks of data to write.
-         * @details Opens the ring buffer if not already open, handles new ring buffer requests, and writes sample data to the ring buffer.
+         * @brief Write the oldest samples of the queue to the ring buffer.
+         * @param[in] numSamples The number of samples to write. The samples are not removed from the queue.
+         * @details Samples are written in batches of contiguous slots. A batch ends at the end of the slot memory or before
+         * a sample that requests a new ring buffer.
          */
-        void WriteChunks(std::vector<chunk_data>& dataChunks){
+        void WriteQueue(size_t numSamples){
+            size_t k = 0;
+            while(k < numSamples){
+                PrepareRingBuffer(queue.Flag(k));
+                size_t maxBatchSize = queue.Contiguous(k);
+                maxBatchSize = ((numSamples - k) < maxBatchSize) ? (numSamples - k) : maxBatchSize;
+                size_t batchSize = 1;
+                while((batchSize < maxBatchSize) && !queue.Flag(k + batchSize)){
+                    ++batchSize;
+                }
+                auto t0 = std::chrono::steady_clock::now();
+                if(file_options.variable_length){
+                    ringBuffer->WriteRecords(queue.Sample(k), queue.Lengths(k), batchSize, queue.Timestamps(k));
+                }
+                else{
+                    ((*ringBuffer).*write_samples)(queue.Sample(k), batchSize, queue.Timestamps(k));
+                }
+                auto t1 = std::chrono::steady_clock::now();
+                uint64_t timeWritten = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1.time_since_epoch()).count());
+                size_t numBytes = 0;
+                for(size_t i = 0; i < batchSize; ++i){
+                    uint64_t timeAdded = queue.Timestamp(k + i);
+                    statistics.AddLatency((timeWritten > timeAdded) ? (timeWritten - timeAdded) : 0);
+                    numBytes += file_options.variable_length ? queue.Lengths(k)[i] : sample_size;
+                }
+                statistics.AddBatch(numBytes, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+                k += batchSize;
+            }
+        }
+
+        /**
+         * @brief Prepare the ring buffer before writing samples.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @details Opens the ring buffer if not already open and handles new ring buffer requests.
+         */
+        void PrepareRingBuffer(bool startNewRingBuffer){
             // open ring buffer if not already open
-            if(!ringBuffer.IsOpen()){
-                ring_counter++;
-                std::filesystem::path directory = data_folder / GenerateSubdirectoryName();
-                ringBuffer.Open(directory.string().c_str(), sample_size, num_samples_per_file, num_files);
-            }
-
-            // handle new ring buffer requests and write sample data
-            for(auto&& chunk : dataChunks){
-                if(chunk.start_new_ring_buffer){
-                    ringBuffer.Close();
-                    ring_counter++;
-                    std::filesystem::path directory = data_folder / GenerateSubdirectoryName();
-                    ringBuffer.Open(directory.string().c_str(), sample_size, num_samples_per_file, num_files);
+            if(!ringBuffer->IsOpen()){
+                ActivateNextRingBuffer();
+            }
+            if(startNewRingBuffer){
+                ActivateNextRingBuffer();
+            }
+        }
+
+        /**
+         * @brief Replace the active ring buffer by the ring buffer that has been opened in advance.
+         * @details The previous ring buffer is handed over to the housekeeping thread to be closed. The directory of the new
+         * ring buffer is renamed according to the current UTC time and ring counter. If no ring buffer has been opened in
+         * advance, the new ring buffer is opened directly.
+         */
+        void ActivateNextRingBuffer(void){
+            std::unique_ptr<detail::MultiFileRingBuffer> next;
+            std::unique_lock<std::mutex> lock(mtxRotation);
+            next.swap(nextRingBuffer);
+            if(ringBuffer->IsOpen()){
+                retiredRingBuffers.push_back(std::move(ringBuffer));
+            }
+            lock.unlock();
+            ring_counter++;
+            std::filesystem::path directory = data_folder / GenerateSubdirectoryName();
+            if(!next || !next->Rename(directory.string().c_str())){
+                if(next){
+                    next->Discard();
                 }
-                ringBuffer.Write(&chunk.data[0]);
+                next = std::make_unique<detail::MultiFileRingBuffer>();
+                next->Open(directory.string().c_str(), sample_size, num_samples_per_file, num_files, file_options);
+            }
+            ringBuffer = std::move(next);
+            ringBuffer->SetStatistics(&statistics);
+            is_open = ringBuffer->IsOpen();
+            lock.lock();
+            active_directory = is_open ? ringBuffer->GetDirectory() : std::filesystem::path();
+            lock.unlock();
+            NotifyHousekeeping();
+        }
+
+        /**
+         * @brief Notify the worker thread or the writer service that new samples are available.
+         */
+        void NotifyWriter(void){
+            if(writer_channel){
+                writer_service->NotifyWrite(writer_channel);
+            }
+            else{
+                thread.Notify();
+            }
+        }
+
+        /**
+         * @brief Notify the housekeeping thread or the writer service that housekeeping is required.
+         * @details Does nothing after the channel has been unregistered from the writer service during termination.
+         */
+        void NotifyHousekeeping(void){
+            if(writer_channel){
+                writer_service->NotifyHousekeeping(writer_channel);
+            }
+            else if(!writer_service){
+                housekeepingThread.Notify();
             }
         }
 };
 
 
-} // namespace etf
+/**
+ * @brief Binary ring buffer with a sample size that is known at compile time.
+ * @tparam SampleSize Number of bytes per sample.
+ * @details The sample size is a template parameter, such that adding a sample copies a constant number of bytes, which
+ * the compiler turns into a few fixed-width loads and stores instead of a call to a generic memcpy. The worker thread
+ * writes the samples by @ref detail::MultiFileRingBuffer::WriteFixedSize, such that all copies and filter loops of the
+ * write path have a constant size as well. The data files and all other properties are the same as for @ref BinaryRingBuffer.
+ */
+template <size_t SampleSize>
+class FixedSizeBinaryRingBuffer: public BinaryRingBuffer {
+    static_assert(SampleSize > 0, "The sample size must be greater than zero!");
 
+    public:
+        /**
+         * @brief Type of a single sample.
+         */
+        using sample_type = std::array<uint8_t, SampleSize>;
+
+        /**
+         * @brief Construct a new binary ring buffer object that writes the samples by the fixed-size write path of the files.
+         */
+        FixedSizeBinaryRingBuffer(){ write_samples = &detail::MultiFileRingBuffer::WriteFixedSize<SampleSize>; }
+
+        /**
+         * @brief Initialize the binary ring buffer with a sample size of SampleSize bytes.
+         * @details See @ref BinaryRingBuffer::Initialize for a description of all parameters.
+         */
+        void Initialize(const char* folder, size_t numSamplesPerFile, size_t numFiles, int threadPriority, size_t maxNumCachedSamples = 0, OverflowPolicy overflowPolicy = OverflowPolicy::drop_newest, uint32_t overflowTimeoutUs = 0, uint32_t statisticsPeriodMs = 0, const detail::MultiFileRingBufferOptions& fileOptions = detail::MultiFileRingBufferOptions()){
+            BinaryRingBuffer::Initialize(folder, SampleSize, numSamplesPerFile, numFiles, threadPriority, maxNumCachedSamples, overflowPolicy, overflowTimeoutUs, statisticsPeriodMs, fileOptions);
+        }
+
+        /**
+         * @brief Add a new sample to the binary ring buffer.
+         * @param[in] sample The sample to add.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @return The number of cached samples waiting to be written to disk.
+         */
+        uint32_t AddSample(const sample_type& sample, bool startNewRingBuffer){ return AddSample(sample.data(), startNewRingBuffer); }
+
+        /**
+         * @brief Add a new sample to the binary ring buffer.
+         * @param[in] sampleData Pointer to SampleSize bytes of sample data.
+         * @param[in] startNewRingBuffer Flag indicating whether to start a new ring buffer.
+         * @return The number of cached samples waiting to be written to disk.
+         * @details If the ring buffer has been initialized with a different sample size by @ref BinaryRingBuffer::Initialize,
+         * the sample is added by the generic copy. Only SampleSize bytes are read, the remaining bytes of a larger sample
+         * are zero.
+         */
+        uint32_t AddSample(const void* sampleData, bool startNewRingBuffer){
+            if(SampleSize > GetSampleSize()){
+                return BinaryRingBuffer::AddSample(sampleData, startNewRingBuffer);
+            }
+            if(SampleSize < GetSampleSize()){
+                uint8_t* slot = reinterpret_cast<uint8_t*>(ReserveSample());
+                if(slot){
+                    std::memcpy(slot, sampleData, SampleSize);
+                    std::memset(slot + SampleSize, 0, GetSampleSize() - SampleSize);
+                }
+                return CommitSample(startNewRingBuffer, SampleSize);
+            }
+            return AddFixedSizeSample<SampleSize>(sampleData, startNewRingBuffer);
+        }
+
+        /**
+         * @brief Add a new variable-length sample to the binary ring buffer, see @ref BinaryRingBuffer::AddSample.
+         */
+        uint32_t AddSample(const void* sampleData, size_t length, bool startNewRingBuffer){ return BinaryRingBuffer::AddSample(sampleData, length, startNewRingBuffer); }
+};
+
+
+} // namespace etf
@@ -0,0 +1,576 @@
+/**
+ * @file etf_binary_ring_buffer_reader.hpp
+ * @author Robert Damerius (damerius.mail@gmail.com)
+ * @brief Experimental target feature for replaying a ring buffer that has been recorded by a binary ring buffer.
+ * @date 2025-10-20
+ * @copyright Copyright (c) 2025 Robert Damerius
+ */
+#pragma once
+
+
+/* Include standard libraries */
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <filesystem>
+#include <etf_detail.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/* Default namespace for experimental target features */
+namespace etf {
+
+
+/**
+ * @brief Reader for replaying a completed ring buffer directory that has been written by a binary ring buffer.
+ * @details The layout of the ring buffer is parsed from its "complete.json" file. The samples are read in the order in
+ * which they have been recorded: for raw samples, the oldest sample is located at the writing point if the ring has
+ * wrapped around, otherwise at the beginning of the first file. For blocks and variable-length records, the records are
+ * walked starting with the file after the writing point and the stale records behind the writing point are ignored.
+ * Blocks are decoded (LZ4 and filters) by the reader thread.
+ *
+ * A reader thread prefetches samples into a preallocated lock-free queue. Each call to @ref ReadSample takes the next
+ * sample from the queue without any blocking I/O. The reader thread is notified as soon as the queue is half empty. If
+ * the reader thread falls behind, no sample is output (underrun) and the sample is output by the next call.
+ */
+class BinaryRingBufferReader {
+    public:
+        /**
+         * @brief Construct a new binary ring buffer reader object.
+         */
+        BinaryRingBufferReader(): sample_size(0), file_size(0), num_files(0), writing_file(0), writing_offset(0), num_bytes_written(0), has_bytes_written(false), codec(detail::MultiFileRingBufferCodec::none), filter(detail::MultiFileRingBufferFilter::none), keyframe_interval(0), samples_per_block(0), variable_length(false), loop(false), segment(0), segment_offset(0), chunk_file(0), chunk_offset(0), chunk_fill(0), block_sample(0), block_num_samples(0), block_first_sample(0), end_of_data(false), num_claimed(0), num_underruns(0), num_samples_read(0), thread_error(0) {}
+
+        /**
+         * @brief Destroy the binary ring buffer reader object.
+         */
+        ~BinaryRingBufferReader(){ Terminate(); }
+
+        /**
+         * @brief Open a ring buffer directory, prefetch the first samples and start the reader thread.
+         * @param[in] directory Path to the ring buffer directory that contains the "complete.json" file.
+         * @param[in] maxNumCachedSamples The maximum number of samples to be prefetched. If this value is zero, @ref default_max_num_cached_samples is used.
+         * @param[in] loopReplay True if the replay should restart with the oldest sample after the newest sample has been read.
+         * @param[in] threadOptions Scheduling policy, priority and CPU affinity of the reader thread.
+         * @return True if the ring buffer has been opened, false if the layout could not be parsed or a file could not be opened.
+         * @details The queue is filled before this function returns, such that the first samples are available immediately.
+         */
+        bool Initialize(const char* directory, size_t maxNumCachedSamples = 0, bool loopReplay = false, const detail::ThreadOptions& threadOptions = {detail::ThreadPolicy::other, 0, {}}){
+            Terminate();
+            folder = std::filesystem::path(directory);
+            if(!ParseLayout(folder / "complete.json")){
+                Terminate();
+                return false;
+            }
+            for(size_t k = 0; k < num_files; ++k){
+                int fd = open((folder / ("buffer" + std::to_string(k) + ".dat")).string().c_str(), O_RDONLY);
+                if(fd < 0){
+                    Terminate();
+                    return false;
+                }
+                fds.push_back(fd);
+            }
+            loop = loopReplay;
+            BuildSegments();
+            size_t maxRecordSize = variable_length ? (record_header_size + sample_size) : (block_header_size + samples_per_block * sample_size);
+            chunk.resize((maxRecordSize > chunk_size) ? maxRecordSize : chunk_size);
+            if(IsBlockMode()){
+                block_raw.resize(samples_per_block * sample_size);
+            }
+            queue.Resize(sample_size, maxNumCachedSamples ? maxNumCachedSamples : default_max_num_cached_samples);
+            Prefetch();
+            thread_error = thread.Start(std::bind(&BinaryRingBufferReader::Prefetch, this), threadOptions);
+            return true;
+        }
+
+        /**
+         * @brief Stop the reader thread, close all files and release all memory.
+         */
+        void Terminate(void){
+            thread.Stop();
+            queue.Release();
+            for(auto&& fd : fds){
+                close(fd);
+            }
+            fds.clear();
+            folder.clear();
+            segments.clear();
+            std::vector<uint8_t>().swap(chunk);
+            std::vector<uint8_t>().swap(block_raw);
+            sample_size = 0;
+            file_size = 0;
+            num_files = 0;
+            writing_file = 0;
+            writing_offset = 0;
+            num_bytes_written = 0;
+            has_bytes_written = false;
+            codec = detail::MultiFileRingBufferCodec::none;
+            filter = detail::MultiFileRingBufferFilter::none;
+            keyframe_interval = 0;
+            samples_per_block = 0;
+            variable_length = false;
+            loop = false;
+            segment = 0;
+            segment_offset = 0;
+            chunk_file = 0;
+            chunk_offset = 0;
+            chunk_fill = 0;
+            block_sample = 0;
+            block_num_samples = 0;
+            block_first_sample = 0;
+            end_of_data.store(false);
+            num_claimed = 0;
+            num_underruns = 0;
+            num_samples_read = 0;
+            thread_error = 0;
+        }
+
+        /**
+         * @brief Read the next sample.
+         * @param[out] bytes Output array, where to store the sample.
+         * @param[in] maxNumBytes Maximum number of bytes that fit into the output array.
+         * @return Number of bytes of the sample that have been copied to the output array. Zero if no sample is available,
+         * either because the end of the ring buffer has been reached or because of an underrun.
+         * @details This function does not take any lock and does not perform any I/O.
+         */
+        uint32_t ReadSample(uint8_t* bytes, uint32_t maxNumBytes){
+            if(!bytes || !queue.Capacity()){
+                return 0;
+            }
+            if(!num_claimed){
+                num_claimed = queue.Claim();
+                if(!num_claimed && end_of_data.load(std::memory_order_acquire)){
+                    num_claimed = queue.Claim(); // samples that have been pushed before the end has been reached
+                    if(!num_claimed){
+                        return 0;
+                    }
+                }
+                if(!num_claimed){
+                    num_underruns++;
+                    thread.Notify();
+                    return 0;
+                }
+            }
+            uint32_t length = queue.Lengths(0)[0];
+            length = (length < maxNumBytes) ? length : maxNumBytes;
+            std::memcpy(bytes, queue.Sample(0), length);
+            queue.Pop(1);
+            num_claimed--;
+            num_samples_read++;
+            if((queue.Size() << 1) <= queue.Capacity()){
+                thread.Notify();
+            }
+            return length;
+        }
+
+        /**
+         * @brief Check whether all samples have been read.
+         * @return True if the end of the ring buffer has been reached and all prefetched samples have been read.
+         */
+        bool IsEndOfData(void) const { return !num_claimed && end_of_data.load(std::memory_order_acquire) && !queue.Size(); }
+
+        /**
+         * @brief Check whether a ring buffer is open.
+         * @return True if a ring buffer has been opened by @ref Initialize, false otherwise.
+         */
+        bool IsOpen(void) const { return !fds.empty(); }
+
+        /**
+         * @brief Get the sample size of the ring buffer.
+         * @return Number of bytes per sample, the maximum length for variable-length records.
+         */
+        size_t GetSampleSize(void) const { return sample_size; }
+
+        /**
+         * @brief Get the number of calls to @ref ReadSample that could not output a sample because the reader thread fell behind.
+         * @return Number of underruns since the last initialization.
+         */
+        size_t GetNumUnderruns(void) const { return num_underruns; }
+
+        /**
+         * @brief Get the number of samples that have been read.
+         * @return Number of samples that have been output by @ref ReadSample since the last initialization.
+         */
+        size_t GetNumSamplesRead(void) const { return num_samples_read; }
+
+        /**
+         * @brief Get the result of applying the thread options to the reader thread.
+         * @return Zero on success, otherwise the error number of the first operation that failed.
+         */
+        int GetThreadError(void) const { return thread_error; }
+
+        /**
+         * @brief Default maximum number of samples to be prefetched if no value is specified during initialization.
+         */
+        static constexpr size_t default_max_num_cached_samples = 4096;
+
+    private:
+        /**
+         * @brief A contiguous byte range of a file that is read in the order of the ring.
+         */
+        struct segment_range {
+            size_t file;                          // Index of the file.
+            size_t begin;                         // Offset of the first byte.
+            size_t end;                           // Offset behind the last byte.
+        };
+
+        static constexpr size_t chunk_size = 1 << 20;            // Minimum number of bytes that are read from a file at once.
+        static constexpr size_t block_header_size = 24;          // Size of the header of a block, see @ref detail::MultiFileRingBuffer.
+        static constexpr uint32_t block_magic = 0x42465445;      // Magic number at the beginning of each block header ("ETFB").
+        static constexpr size_t record_header_size = 4;          // Size of the length prefix of a variable-length record.
+        size_t sample_size;                       // Number of bytes per sample, maximum length for variable-length records.
+        size_t file_size;                         // Number of data bytes per file (without padding).
+        size_t num_files;                         // Number of files of the ring buffer.
+        size_t writing_file;                      // File index of the writing point.
+        size_t writing_offset;                    // Byte offset of the writing point.
+        uint64_t num_bytes_written;               // Total number of bytes that have been written to the ring buffer.
+        bool has_bytes_written;                   // True if the number of written bytes is known, otherwise the ring is assumed to have wrapped around.
+        detail::MultiFileRingBufferCodec codec;   // Codec of the blocks.
+        detail::MultiFileRingBufferFilter filter; // Filter of the blocks.
+        size_t keyframe_interval;                 // Interval of additional keyframes of the filter, zero if disabled.
+        size_t samples_per_block;                 // Maximum number of samples per block.
+        bool variable_length;                     // True if samples are stored as variable-length records.
+        bool loop;                                // True if the replay restarts after the newest sample.
+        std::filesystem::path folder;             // Directory of the ring buffer.
+        std::vector<int> fds;                     // File descriptors of all data files.
+        std::vector<segment_range> segments;      // Byte ranges of all files in the order of the ring.
+        size_t segment;                           // Index of the current segment, reader thread only.
+        size_t segment_offset;                    // File offset of the next sample or record in the current segment, reader thread only.
+        std::vector<uint8_t> chunk;               // Bytes that have been read from a file, reader thread only.
+        size_t chunk_file;                        // File index of the chunk.
+        size_t chunk_offset;                      // File offset of the first byte of the chunk.
+        size_t chunk_fill;                        // Number of valid bytes of the chunk.
+        std::vector<uint8_t> block_raw;           // Decoded samples of the current block, reader thread only.
+        size_t block_sample;                      // Index of the next sample of the current block.
+        size_t block_num_samples;                 // Number of samples of the current block.
+        uint64_t block_first_sample;              // Index of the first sample of the current block.
+        std::atomic<bool> end_of_data;            // True if the reader thread has pushed the newest sample and does not loop.
+        detail::SampleQueue queue;                // Queue of prefetched samples, the reader thread is the producer.
+        size_t num_claimed;                       // Number of claimed samples that have not been read yet, consumer only.
+        size_t num_underruns;                     // Number of underruns, consumer only.
+        size_t num_samples_read;                  // Number of samples that have been read, consumer only.
+        int thread_error;                         // Result of applying the thread options.
+        detail::NotifyableThread thread;          // Reader thread that prefetches samples.
+
+        /**
+         * @brief Check whether samples are stored in blocks.
+         * @return True if a codec or a filter has been used, false otherwise.
+         */
+        bool IsBlockMode(void) const { return (detail::MultiFileRingBufferCodec::none != codec) || (detail::MultiFileRingBufferFilter::none != filter); }
+
+        /**
+         * @brief Find the value of a key in a JSON document.
+         * @param[in] json The JSON document.
+         * @param[in] key The key without quotes.
+         * @param[out] value The value without quotes (strings) or the text of a number.
+         * @return True if the key has been found, false otherwise.
+         * @details This is a minimal parser for the flat "complete.json" files of @ref detail::MultiFileRingBuffer, where
+         * each key is unique within the document.
+         */
+        static bool FindValue(const std::string& json, const char* key, std::string& value){
+            std::string quotedKey(1, '"');
+            quotedKey.append(key).push_back('"');
+            size_t pos = json.find(quotedKey);
+            if(std::string::npos == pos){
+                return false;
+            }
+            pos = json.find(':', pos);
+            if(std::string::npos == pos){
+                return false;
+            }
+            pos = json.find_first_not_of(" \t\r\n", pos + 1);
+            if(std::string::npos == pos){
+                return false;
+            }
+            if('"' == json[pos]){
+                size_t end = json.find('"', pos + 1);
+                value = json.substr(pos + 1, (std::string::npos == end) ? std::string::npos : (end - pos - 1));
+                return true;
+            }
+            size_t end = json.find_first_of(",}\r\n", pos);
+            value = json.substr(pos, (std::string::npos == end) ? std::string::npos : (end - pos));
+            return true;
+        }
+
+        /**
+         * @brief Find an unsigned integer value of a key in a JSON document.
+         * @param[in] json The JSON document.
+         * @param[in] key The key without quotes.
+         * @param[out] value The value.
+         * @return True if the key has been found, false otherwise.
+         */
+        static bool FindInteger(const std::string& json, const char* key, uint64_t& value){
+            std::string text;
+            if(!FindValue(json, key, text)){
+                return false;
+            }
+            value = std::strtoull(text.c_str(), nullptr, 10);
+            return true;
+        }
+
+        /**
+         * @brief Parse the layout of the ring buffer from a "complete.json" file.
+         * @param[in] filename Path to the "complete.json" file.
+         * @return True if success, false otherwise.
+         */
+        bool ParseLayout(std::filesystem::path filename){
+            FILE* fp = fopen(filename.string().c_str(), "r");
+            if(!fp){
+                return false;
+            }
+            std::string json;
+            char buffer[1024];
+            size_t n;
+            while((n = fread(buffer, 1, sizeof(buffer), fp)) > 0){
+                json.append(buffer, n);
+            }
+            fclose(fp);
+            uint64_t bytesPerSample = 0, bytesPerFile = 0, numFiles = 0, fileIndex = 0, byteOffset = 0;
+            if(!FindInteger(json, "bytes_per_sample", bytesPerSample) || !FindInteger(json, "bytes_per_file", bytesPerFile) || !FindInteger(json, "files_per_ringbuffer", numFiles) || !FindInteger(json, "file_index", fileIndex) || !FindInteger(json, "byte_offset", byteOffset)){
+                return false;
+            }
+            if(!bytesPerSample || !bytesPerFile || !numFiles || (fileIndex >= numFiles) || (byteOffset > bytesPerFile)){
+                return false;
+            }
+            sample_size = static_cast<size_t>(bytesPerSample);
+            file_size = static_cast<size_t>(bytesPerFile);
+            num_files = static_cast<size_t>(numFiles);
+            writing_file = static_cast<size_t>(fileIndex);
+            writing_offset = static_cast<size_t>(byteOffset);
+            has_bytes_written = FindInteger(json, "bytes_written", num_bytes_written);
+            std::string text;
+            codec = (FindValue(json, "codec", text) && ("lz4" == text)) ? detail::MultiFileRingBufferCodec::lz4 : detail::MultiFileRingBufferCodec::none;
+            if(FindValue(json, "block_layout", text)){
+                uint64_t value = 0;
+                if(!FindInteger(json, "samples_per_block", value) || !value){
+                    return false;
+                }
+                samples_per_block = static_cast<size_t>(value);
+                keyframe_interval = FindInteger(json, "keyframe_interval", value) ? static_cast<size_t>(value) : 0;
+                filter = detail::MultiFileRingBufferFilter::none;
+                if(FindValue(json, "filter", text)){
+                    filter = ("xor_previous" == text) ? detail::MultiFileRingBufferFilter::xor_previous : (("delta_previous" == text) ? detail::MultiFileRingBufferFilter::delta_previous : detail::MultiFileRingBufferFilter::none);
+                }
+                if(!IsBlockMode()){
+                    return false;
+                }
+            }
+            variable_length = FindValue(json, "record_layout", text);
+            return !(variable_length && IsBlockMode());
+        }
+
+        /**
+         * @brief Build the byte ranges of all files in the order of the ring.
+         */
+        void BuildSegments(void){
+            segments.clear();
+            bool wrapped = !has_bytes_written || (num_bytes_written > (static_cast<uint64_t>(writing_file) * file_size + writing_offset));
+            if(!IsBlockMode() && !variable_length){
+                // raw samples are contiguous, the oldest sample is located at the writing point
+                if(wrapped){
+                    segments.push_back({writing_file, writing_offset, file_size});
+                }
+                for(size_t k = 1; k < num_files; ++k){
+                    size_t f = (writing_file + k) % num_files;
+                    if(wrapped || (f < writing_file)){
+                        segments.push_back({f, 0, file_size});
+                    }
+                }
+                segments.push_back({writing_file, 0, writing_offset});
+            }
+            else{
+                // records start at the beginning of each file, the rest of the file at the writing point is stale
+                for(size_t k = 1; k < num_files; ++k){
+                    size_t f = (writing_file + k) % num_files;
+                    if(wrapped || (f < writing_file)){
+                        segments.push_back({f, 0, file_size});
+                    }
+                }
+                segments.push_back({writing_file, 0, writing_offset});
+            }
+            segment = 0;
+            segment_offset = segments[0].begin;
+            chunk_fill = 0;
+            block_sample = 0;
+            block_num_samples = 0;
+        }
+
+        /**
+         * @brief Get bytes of a file via the chunk buffer (reader thread only).
+         * @param[in] file Index of the file.
+         * @param[in] offset File offset of the first byte.
+         * @param[in] numBytes Number of bytes, must not exceed the size of the chunk buffer.
+         * @return Pointer to the bytes or nullptr if the file does not contain these bytes.
+         */
+        const uint8_t* Fetch(size_t file, size_t offset, size_t numBytes){
+            if((file != chunk_file) || (offset < chunk_offset) || ((offset + numBytes) > (chunk_offset + chunk_fill))){
+                chunk_file = file;
+                chunk_offset = offset;
+                chunk_fill = 0;
+                while(chunk_fill < chunk.size()){
+                    ssize_t n = pread(fds[file], &chunk[chunk_fill], chunk.size() - chunk_fill, static_cast<off_t>(offset + chunk_fill));
+                    if(n <= 0){
+                        break;
+                    }
+                    chunk_fill += static_cast<size_t>(n);
+                }
+                if(numBytes > chunk_fill){
+                    return nullptr;
+                }
+            }
+            return &chunk[offset - chunk_offset];
+        }
+
+        /**
+         * @brief Read and decode the next block of the current segment (reader thread only).
+         * @return True if a block has been decoded, false if the segment does not contain any further valid block.
+         */
+        bool ReadBlock(void){
+            const segment_range& range = segments[segment];
+            if((range.end - segment_offset) < block_header_size){
+                return false;
+            }
+            const uint8_t* header = Fetch(range.file, segment_offset, block_header_size);
+            if(!header){
+                return false;
+            }
+            uint32_t magic, payloadSize, rawSize;
+            uint16_t blockCodec;
+            std::memcpy(&magic, header + 0, 4);
+            std::memcpy(&blockCodec, header + 4, 2);
+            std::memcpy(&payloadSize, header + 8, 4);
+            std::memcpy(&rawSize, header + 12, 4);
+            std::memcpy(&block_first_sample, header + 16, 8);
+            if((block_magic != magic) || !rawSize || (rawSize > block_raw.size()) || (rawSize % sample_size) || ((range.end - segment_offset - block_header_size) < payloadSize)){
+                return false;
+            }
+            const uint8_t* payload = Fetch(range.file, segment_offset, block_header_size + payloadSize);
+            if(!payload){
+                return false;
+            }
+            payload += block_header_size;
+            if(static_cast<uint16_t>(detail::MultiFileRingBufferCodec::lz4) == blockCodec){
+                if(!detail::LZ4BlockDecoder::Decode(&block_raw[0], rawSize, payload, payloadSize)){
+                    return false;
+                }
+            }
+            else if(payloadSize == rawSize){
+                std::memcpy(&block_raw[0], payload, rawSize);
+            }
+            else{
+                return false;
+            }
+            segment_offset += block_header_size + payloadSize;
+            block_num_samples = rawSize / sample_size;
+            block_sample = 0;
+            Unfilter();
+            return true;
+        }
+
+        /**
+         * @brief Restore the raw samples of the current block from the filtered samples (reader thread only).
+         * @details The first sample of a block and all keyframes are stored unfiltered, see @ref detail::MultiFileRingBuffer.
+         */
+        void Unfilter(void){
+            if(detail::MultiFileRingBufferFilter::none == filter){
+                return;
+            }
+            uint8_t* raw = &block_raw[0];
+            for(size_t k = 1; k < block_num_samples; ++k){
+                if(keyframe_interval && !((block_first_sample + k) % keyframe_interval)){
+                    continue; // keyframe
+                }
+                uint8_t* dst = raw + k * sample_size;
+                const uint8_t* prev = dst - sample_size;
+                if(detail::MultiFileRingBufferFilter::xor_previous == filter){
+                    for(size_t i = 0; i < sample_size; ++i){
+                        dst[i] ^= prev[i];
+                    }
+                }
+                else{
+                    for(size_t i = 0; i < sample_size; ++i){
+                        dst[i] = static_cast<uint8_t>(dst[i] + prev[i]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Copy the next sample of the current segment into a slot (reader thread only).
+         * @param[out] slot Slot of the queue with at least sample size bytes.
+         * @param[out] length Number of valid bytes of the sample.
+         * @return True if a sample has been copied, false if the current segment does not contain any further sample.
+         */
+        bool NextSample(uint8_t* slot, uint32_t& length){
+            const segment_range& range = segments[segment];
+            if(IsBlockMode()){
+                if((block_sample >= block_num_samples) && !ReadBlock()){
+                    return false;
+                }
+                std::memcpy(slot, &block_raw[block_sample * sample_size], sample_size);
+                block_sample++;
+                length = static_cast<uint32_t>(sample_size);
+                return true;
+            }
+            if(variable_length){
+                const uint8_t* header = ((range.end - segment_offset) >= record_header_size) ? Fetch(range.file, segment_offset, record_header_size) : nullptr;
+                if(!header){
+                    return false;
+                }
+                std::memcpy(&length, header, record_header_size);
+                if(!length || (length > sample_size) || ((range.end - segment_offset - record_header_size) < length)){
+                    return false; // zero padding marks the end of a file
+                }
+                const uint8_t* record = Fetch(range.file, segment_offset, record_header_size + length);
+                if(!record){
+                    return false;
+                }
+                std::memcpy(slot, record + record_header_size, length);
+                segment_offset += record_header_size + length;
+                return true;
+            }
+            const uint8_t* sample = ((range.end - segment_offset) >= sample_size) ? Fetch(range.file, segment_offset, sample_size) : nullptr;
+            if(!sample){
+                return false;
+            }
+            std::memcpy(slot, sample, sample_size);
+            segment_offset += sample_size;
+            length = static_cast<uint32_t>(sample_size);
+            return true;
+        }
+
+        /**
+         * @brief Fill the queue with the next samples (reader thread only).
+         * @details Moves on to the next segment when the current segment is exhausted. After the last segment, the replay
+         * either restarts with the first segment or the end of the data is indicated.
+         */
+        void Prefetch(void){
+            uint8_t* slot;
+            while(!end_of_data.load(std::memory_order_relaxed) && (slot = queue.Reserve())){
+                uint32_t length = 0;
+                size_t numExhausted = 0;
+                while(!NextSample(slot, length)){
+                    block_sample = 0;
+                    block_num_samples = 0;
+                    if(++segment >= segments.size()){
+                        segment = 0;
+                        if(!loop || (++numExhausted > 1)){
+                            end_of_data.store(true, std::memory_order_release); // no more samples or no sample at all
+                            return;
+                        }
+                    }
+                    segment_offset = segments[segment].begin;
+                }
+                queue.Commit(false, 0, length);
+            }
+        }
+};
+
+
+} // namespace etf
+
@@ -5,13 +5,38 @@
 #include <cstdio>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 #include <vector>
+#include <string>
+#include <tuple>
+#include <fstream>
 #include <filesystem>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
+#include <semaphore>
 #include <atomic>
 #include <functional>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <map>
+#include <algorithm>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <cstdlib>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define ETF_HAS_IO_URING 1
+#else
+#define ETF_HAS_IO_URING 0
+#endif
 
 
 /* Default namespace for experimental target features */
@@ -22,16 +47,727 @@ namespace etf {
 namespace detail {
 
 
+/**
+ * @brief Backend that is used by a multi-file ring buffer to write data to the files.
+ */
+enum class MultiFileRingBufferBackend {
+    stdio_stream,                         // Buffered stdio streams, files grow while they are written for the first time.
+    memory_mapped,                        // Files are resized to their final size when opened and mapped into memory, data is written by memcpy.
+    direct_io,                            // Files are opened with O_DIRECT, data is gathered in an aligned staging buffer and written in whole blocks. Each file is padded to a multiple of the block size.
+    io_uring_async                        // Data is gathered in staging buffers and written asynchronously via io_uring with several writes in flight. Falls back to stdio streams if io_uring is not available.
+};
+
+
+/**
+ * @brief Codec that is used by a multi-file ring buffer to compress blocks of samples.
+ */
+enum class MultiFileRingBufferCodec : uint8_t {
+    none = 0,                             // Samples are written as they are.
+    lz4 = 1                               // Blocks of samples are compressed in the LZ4 block format and written as records with a block header.
+};
+
+
+/**
+ * @brief Filter that is applied to the samples of a block before they are compressed.
+ * @details Both filters operate byte-wise on each sample and the previous sample of the same block. Keyframes are stored
+ * unfiltered. The first sample of each block is always a keyframe.
+ */
+enum class MultiFileRingBufferFilter : uint8_t {
+    none = 0,                             // Samples are not filtered.
+    xor_previous = 1,                     // Each byte is XORed with the corresponding byte of the previous sample.
+    delta_previous = 2                    // The corresponding byte of the previous sample is subtracted from each byte (modulo 256).
+};
+
+
+/**
+ * @brief Durability tier of a multi-file ring buffer, i.e. when written data is synchronized to the storage device.
+ * @details Flushing only hands buffered data over to the operating system. Only synchronized data (fdatasync, msync
+ * for memory-mapped files) survives a power loss.
+ */
+enum class MultiFileRingBufferDurability : uint8_t {
+    none = 0,                             // Data is never synchronized explicitly, the operating system decides when it reaches the storage device.
+    on_close = 1,                         // All files are synchronized when the ring buffer is closed, i.e. on ring rotation and termination.
+    periodic = 2                          // Like on_close, the current file is also synchronized according to the sync options and each file is synchronized when it is completed.
+};
+
+
+/**
+ * @brief Options for a multi-file ring buffer.
+ */
+struct MultiFileRingBufferOptions {
+    MultiFileRingBufferBackend backend = MultiFileRingBufferBackend::stdio_stream; // Backend to be used for writing data.
+    bool preallocate = false;             // True if disk space for all files is reserved when opening the ring buffer, such that no blocks have to be allocated while writing.
+    size_t flush_bytes = 0;               // Flush buffered data (msync for memory-mapped files) once at least this number of bytes has been written since the last flush. Zero flushes after every write call.
+    uint32_t flush_period_ms = 0;         // Flush buffered data (msync for memory-mapped files) if this period in milliseconds has elapsed since the last flush. Zero disables the period.
+    size_t async_num_buffers = 8;         // Number of staging buffers and therefore the maximum number of writes in flight (io_uring only).
+    size_t async_buffer_size = 1 << 16;   // Size of each staging buffer in bytes (io_uring only).
+    MultiFileRingBufferCodec codec = MultiFileRingBufferCodec::none; // Codec for compressing blocks of samples.
+    size_t block_num_samples = 256;       // Number of samples per block (compression or filter only).
+    MultiFileRingBufferFilter filter = MultiFileRingBufferFilter::none; // Filter that is applied to each block before it is compressed. A filter without a codec still writes blocks.
+    size_t keyframe_interval = 0;         // Additional keyframe every keyframe_interval samples (counted from the first sample of the ring buffer), zero for keyframes at block starts only.
+    size_t journal_interval_samples = 0;  // Flush and record the writing point in a memory-mapped "journal.bin" file every journal_interval_samples samples (and at each sync point of the periodic durability tier), zero disables the journal.
+    bool variable_length = false;         // Write each sample as a record of a uint32 length followed by the valid bytes, the sample size is the maximum length. Cannot be combined with a codec or a filter.
+    MultiFileRingBufferDurability durability = MultiFileRingBufferDurability::none; // Durability tier, see @ref MultiFileRingBufferDurability.
+    size_t sync_bytes = 0;                // Synchronize the current file once at least this number of bytes has been written since the last synchronization (periodic durability only).
+    uint32_t sync_period_ms = 0;          // Synchronize the current file if this period in milliseconds has elapsed since the last synchronization (periodic durability only). If both sync options are zero, the file is synchronized after every write call.
+    size_t time_index_interval_samples = 0; // Add an entry to the time index file "bufferN.idx" of the current file every time_index_interval_samples samples (at most one entry per block), zero disables the time index.
+};
+
+
+/**
+ * @brief Encoder for the LZ4 block format.
+ * @details Implements a greedy single-pass LZ4 compressor with a fixed-size hash table, such that no heap memory is
+ * allocated while encoding. The output can be decoded by any LZ4 block decoder (e.g. LZ4_decompress_safe) if the
+ * decoded size is known.
+ */
+class LZ4BlockEncoder {
+    public:
+        /**
+         * @brief Construct a new LZ4 block encoder and allocate its hash table.
+         */
+        LZ4BlockEncoder(): table(size_t(1) << hash_log, 0) {}
+
+        /**
+         * @brief Get the maximum size of the encoded data.
+         * @param[in] numBytes Number of bytes to be encoded.
+         * @return Maximum number of bytes that @ref Encode writes to the output.
+         */
+        static constexpr size_t Bound(size_t numBytes){ return numBytes + (numBytes / 255) + 16; }
+
+        /**
+         * @brief Encode data in the LZ4 block format.
+         * @param[out] dst Output buffer with at least @ref Bound(numBytes) bytes.
+         * @param[in] src Data to be encoded.
+         * @param[in] numBytes Number of bytes to be encoded.
+         * @return Number of encoded bytes.
+         */
+        size_t Encode(uint8_t* dst, const uint8_t* src, size_t numBytes){
+            constexpr size_t min_match = 4;        // Minimum match length of the format.
+            constexpr size_t last_literals = 5;    // The last bytes of a block are always literals.
+            constexpr size_t match_limit = 12;     // The last match must start at least this number of bytes before the end.
+            std::fill(table.begin(), table.end(), 0);
+            uint8_t* op = dst;
+            size_t anchor = 0;
+            size_t ip = 0;
+            if(numBytes > match_limit){
+                while(ip < (numBytes - match_limit)){
+                    uint32_t sequence = Read32(src + ip);
+                    uint32_t& entry = table[(sequence * 2654435761u) >> (32 - hash_log)];
+                    size_t ref = entry; // position + 1, zero if empty
+                    entry = static_cast<uint32_t>(ip + 1);
+                    if(!ref || ((ip + 1 - ref) > 65535) || (Read32(src + ref - 1) != sequence)){
+                        ++ip;
+                        continue;
+                    }
+                    --ref;
+                    size_t matchLength = min_match;
+                    while(((ip + matchLength) < (numBytes - last_literals)) && (src[ref + matchLength] == src[ip + matchLength])){
+                        ++matchLength;
+                    }
+                    op = WriteSequence(op, src + anchor, ip - anchor, matchLength - min_match);
+                    uint16_t offset = static_cast<uint16_t>(ip - ref);
+                    *op++ = static_cast<uint8_t>(offset & 0xFF);
+                    *op++ = static_cast<uint8_t>(offset >> 8);
+                    size_t extra = matchLength - min_match;
+                    if(extra >= 15){
+                        op = WriteLength(op, extra - 15);
+                    }
+                    ip += matchLength;
+                    anchor = ip;
+                }
+            }
+            op = WriteSequence(op, src + anchor, numBytes - anchor, 0);
+            return static_cast<size_t>(op - dst);
+        }
+
+    private:
+        static constexpr uint32_t hash_log = 12;   // Logarithm of the number of hash table entries.
+        std::vector<uint32_t> table;               // Hash table of positions (plus one) of previous 4-byte sequences.
+
+        static uint32_t Read32(const uint8_t* p){ uint32_t value; std::memcpy(&value, p, sizeof(value)); return value; }
+
+        static uint8_t* WriteLength(uint8_t* op, size_t length){
+            for(; length >= 255; length -= 255){
+                *op++ = 255;
+            }
+            *op++ = static_cast<uint8_t>(length);
+            return op;
+        }
+
+        static uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals, size_t numLiterals, size_t matchExtra){
+            *op++ = static_cast<uint8_t>(((numLiterals < 15) ? numLiterals : 15) << 4) | static_cast<uint8_t>((matchExtra < 15) ? matchExtra : 15);
+            if(numLiterals >= 15){
+                op = WriteLength(op, numLiterals - 15);
+            }
+            std::memcpy(op, literals, numLiterals);
+            return op + numLiterals;
+        }
+};
+
+/**
+ * @brief Decoder for the LZ4 block format.
+ * @details Decodes blocks that have been encoded by @ref LZ4BlockEncoder or by any other LZ4 block encoder. All offsets
+ * and lengths are checked, such that corrupted input never leads to an access outside of the buffers.
+ */
+class LZ4BlockDecoder {
+    public:
+        /**
+         * @brief Decode data in the LZ4 block format.
+         * @param[out] dst Output buffer.
+         * @param[in] dstSize Number of bytes of the decoded data, the output buffer must have at least this size.
+         * @param[in] src Encoded data.
+         * @param[in] srcSize Number of bytes of the encoded data.
+         * @return True if exactly dstSize bytes have been decoded, false if the encoded data is invalid.
+         */
+        static bool Decode(uint8_t* dst, size_t dstSize, const uint8_t* src, size_t srcSize){
+            size_t ip = 0;
+            size_t op = 0;
+            while(ip < srcSize){
+                size_t token = src[ip++];
+                size_t numLiterals = token >> 4;
+                if(15 == numLiterals){
+                    uint8_t b;
+                    do{
+                        if(ip >= srcSize){
+                            return false;
+                        }
+                        b = src[ip++];
+                        numLiterals += b;
+                    } while(255 == b);
+                }
+                if((numLiterals > (srcSize - ip)) || (numLiterals > (dstSize - op))){
+                    return false;
+                }
+                std::memcpy(dst + op, src + ip, numLiterals);
+                ip += numLiterals;
+                op += numLiterals;
+                if(ip >= srcSize){
+                    break; // the last sequence consists of literals only
+                }
+                if((srcSize - ip) < 2){
+                    return false;
+                }
+                size_t offset = static_cast<size_t>(src[ip]) | (static_cast<size_t>(src[ip + 1]) << 8);
+                ip += 2;
+                size_t matchLength = (token & 15) + 4;
+                if(19 == matchLength){
+                    uint8_t b;
+                    do{
+                        if(ip >= srcSize){
+                            return false;
+                        }
+                        b = src[ip++];
+                        matchLength += b;
+                    } while(255 == b);
+                }
+                if(!offset || (offset > op) || (matchLength > (dstSize - op))){
+                    return false;
+                }
+                for(size_t i = 0; i < matchLength; ++i, ++op){
+                    dst[op] = dst[op - offset]; // byte-wise, since source and destination may overlap
+                }
+            }
+            return op == dstSize;
+        }
+};
+
+
+/**
+ * @brief Asynchronous file writer based on io_uring.
+ * @details Data is copied into one of several staging buffers. A staging buffer is submitted as a single write request
+ * as soon as it is full, when data for a non-adjoining file range arrives or when @ref Submit is called. Staging buffers
+ * are recycled when their write requests complete. The writer only blocks if all staging buffers are in flight.
+ */
+class AsyncFileWriter {
+    public:
+        /**
+         * @brief Construct a new asynchronous file writer object.
+         */
+        AsyncFileWriter(): ring_fd(-1), sq_ring(nullptr), cq_ring(nullptr), sqes(nullptr), sq_ring_size(0), cq_ring_size(0), sqes_size(0), sq_tail(nullptr), sq_mask(nullptr), sq_array(nullptr), cq_head(nullptr), cq_tail(nullptr), cq_mask(nullptr), cqes(nullptr), buffer_size(0), current(0), num_in_flight(0) {}
+
+        /**
+         * @brief Destroy the asynchronous file writer object.
+         * @details Waits for all write requests to complete.
+         */
+        ~AsyncFileWriter(){ Close(); }
+
+        /**
+         * @brief Set up the io_uring instance and allocate all staging buffers.
+         * @param[in] numBuffers Number of staging buffers, which is the maximum number of writes in flight.
+         * @param[in] bufferSize Size of each staging buffer in bytes.
+         * @return True if success, false if io_uring is not available.
+         */
+        bool Open(size_t numBuffers, size_t bufferSize){
+            Close();
+            #if ETF_HAS_IO_URING
+            numBuffers = numBuffers ? numBuffers : 1;
+            buffer_size = bufferSize ? bufferSize : 1;
+            struct io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(numBuffers), &params));
+            if(ring_fd < 0){
+                Close();
+                return false;
+            }
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+            sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+            if(params.features & IORING_FEAT_SINGLE_MMAP){
+                sq_ring_size = (cq_ring_size > sq_ring_size) ? cq_ring_size : sq_ring_size;
+                cq_ring_size = 0;
+            }
+            sq_ring = MapRing(sq_ring_size, IORING_OFF_SQ_RING);
+            cq_ring = cq_ring_size ? MapRing(cq_ring_size, IORING_OFF_CQ_RING) : sq_ring;
+            sqes = MapRing(sqes_size, IORING_OFF_SQES);
+            if(!sq_ring || !cq_ring || !sqes){
+                Close();
+                return false;
+            }
+            sq_tail = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+            sq_mask = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+            cq_mask = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+            cqes = cq_ring + params.cq_off.cqes;
+
+            // allocate staging buffers
+            buffers.resize(numBuffers < params.sq_entries ? numBuffers : params.sq_entries);
+            for(auto&& buffer : buffers){
+                buffer.data.resize(buffer_size);
+            }
+            current = 0;
+            num_in_flight = 0;
+            return true;
+            #else
+            (void)numBuffers;
+            (void)bufferSize;
+            return false;
+            #endif
+        }
+
+        /**
+         * @brief Submit the remaining data, wait for all write requests to complete and release all resources.
+         */
+        void Close(void){
+            if(!buffers.empty()){
+                Submit();
+                WaitAll();
+            }
+            buffers.clear();
+            if(sqes){
+                munmap(sqes, sqes_size);
+            }
+            if(cq_ring && (cq_ring != sq_ring)){
+                munmap(cq_ring, cq_ring_size);
+            }
+            if(sq_ring){
+                munmap(sq_ring, sq_ring_size);
+            }
+            if(ring_fd >= 0){
+                close(ring_fd);
+            }
+            ring_fd = -1;
+            sq_ring = nullptr;
+            cq_ring = nullptr;
+            sqes = nullptr;
+            sq_tail = sq_mask = sq_array = cq_head = cq_tail = cq_mask = nullptr;
+            cqes = nullptr;
+            buffer_size = 0;
+            current = 0;
+            num_in_flight = 0;
+        }
+
+        /**
+         * @brief Write data to a file.
+         * @param[in] fd The file descriptor.
+         * @param[in] offset The file offset where to write the data.
+         * @param[in] bytes Pointer to the data.
+         * @param[in] numBytes Number of bytes to write.
+         * @details The data is copied into staging buffers, the call returns before the data has been written.
+         */
+        void Write(int fd, size_t offset, const uint8_t* bytes, size_t numBytes){
+            if(buffers.empty()){
+                return;
+            }
+            while(numBytes){
+                staging_buffer& buffer = buffers[current];
+                if(buffer.fill && ((buffer.fd != fd) || ((buffer.offset + buffer.fill) != offset))){
+                    Submit();
+                    continue;
+                }
+                if(!buffer.fill){
+                    buffer.fd = fd;
+                    buffer.offset = offset;
+                }
+                size_t n = buffer_size - buffer.fill;
+                n = (numBytes < n) ? numBytes : n;
+                std::memcpy(buffer.data.data() + buffer.fill, bytes, n);
+                buffer.fill += n;
+                bytes += n;
+                offset += n;
+                numBytes -= n;
+                if(buffer_size == buffer.fill){
+                    Submit();
+                }
+            }
+        }
+
+        /**
+         * @brief Submit the current staging buffer as write request if it contains data.
+         * @details Blocks until a completion has arrived if no other staging buffer is free.
+         */
+        void Submit(void){
+            #if ETF_HAS_IO_URING
+            if(buffers.empty() || !buffers[current].fill){
+                return;
+            }
+            staging_buffer& buffer = buffers[current];
+            unsigned tail = *sq_tail;
+            unsigned k = tail & *sq_mask;
+            struct io_uring_sqe* sqe = reinterpret_cast<struct io_uring_sqe*>(sqes) + k;
+            std::memset(sqe, 0, sizeof(struct io_uring_sqe));
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = buffer.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer.data.data());
+            sqe->len = static_cast<uint32_t>(buffer.fill);
+            sqe->off = static_cast<uint64_t>(buffer.offset);
+            sqe->user_data = static_cast<uint64_t>(current);
+            sq_array[k] = k;
+            std::atomic_ref<unsigned>(*sq_tail).store(tail + 1, std::memory_order_release);
+            buffer.in_flight = true;
+            ++num_in_flight;
+            (void)syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0);
+
+            // select next free staging buffer, wait for completions if all buffers are in flight
+            Reap(false);
+            while(num_in_flight >= buffers.size()){
+                Reap(true);
+            }
+            for(size_t i = 1; i <= buffers.size(); ++i){
+                size_t next = (current + i) % buffers.size();
+                if(!buffers[next].in_flight){
+                    current = next;
+                    break;
+                }
+            }
+            #endif
+        }
+
+        /**
+         * @brief Wait until all submitted write requests have completed.
+         */
+        void WaitAll(void){
+            while(num_in_flight){
+                Reap(true);
+            }
+        }
+
+    private:
+        struct staging_buffer {
+            std::vector<uint8_t> data;        // Memory of the staging buffer.
+            int fd = -1;                      // File descriptor the data belongs to.
+            size_t offset = 0;                // File offset of the first byte.
+            size_t fill = 0;                  // Number of valid bytes.
+            bool in_flight = false;           // True if a write request for this buffer has not completed yet.
+        };
+
+        int ring_fd;                          // File descriptor of the io_uring instance.
+        uint8_t* sq_ring;                     // Mapped submission queue ring.
+        uint8_t* cq_ring;                     // Mapped completion queue ring, may be equal to @ref sq_ring.
+        uint8_t* sqes;                        // Mapped submission queue entries.
+        size_t sq_ring_size;                  // Size of the mapped submission queue ring.
+        size_t cq_ring_size;                  // Size of the mapped completion queue ring, zero if it is part of the submission queue ring.
+        size_t sqes_size;                     // Size of the mapped submission queue entries.
+        unsigned* sq_tail;                    // Tail of the submission queue.
+        unsigned* sq_mask;                    // Index mask of the submission queue.
+        unsigned* sq_array;                   // Index array of the submission queue.
+        unsigned* cq_head;                    // Head of the completion queue.
+        unsigned* cq_tail;                    // Tail of the completion queue.
+        unsigned* cq_mask;                    // Index mask of the completion queue.
+        uint8_t* cqes;                        // Completion queue entries.
+        size_t buffer_size;                   // Size of each staging buffer.
+        size_t current;                       // Index of the staging buffer that is currently filled.
+        size_t num_in_flight;                 // Number of write requests in flight.
+        std::vector<staging_buffer> buffers;  // All staging buffers.
+
+        /**
+         * @brief Map a ring of the io_uring instance into memory.
+         * @param[in] size Size of the ring.
+         * @param[in] offset Magic offset of the ring.
+         * @return Pointer to the mapped memory or nullptr on failure.
+         */
+        uint8_t* MapRing(size_t size, long long offset){
+            void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, static_cast<off_t>(offset));
+            return (MAP_FAILED == mapping) ? nullptr : reinterpret_cast<uint8_t*>(mapping);
+        }
+
+        /**
+         * @brief Process all available completions and recycle their staging buffers.
+         * @param[in] wait True if the function should block until at least one completion is available.
+         * @details Short or failed writes are completed synchronously by pwrite.
+         */
+        void Reap(bool wait){
+            #if ETF_HAS_IO_URING
+            unsigned head = *cq_head;
+            if(wait && (head == std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire))){
+                (void)syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            }
+            while(head != std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire)){
+                struct io_uring_cqe* cqe = reinterpret_cast<struct io_uring_cqe*>(cqes) + (head & *cq_mask);
+                staging_buffer& buffer = buffers[static_cast<size_t>(cqe->user_data)];
+                size_t numWritten = (cqe->res > 0) ? static_cast<size_t>(cqe->res) : 0;
+                if(numWritten < buffer.fill){
+                    (void)pwrite(buffer.fd, buffer.data.data() + numWritten, buffer.fill - numWritten, static_cast<off_t>(buffer.offset + numWritten));
+                }
+                buffer.fill = 0;
+                buffer.in_flight = false;
+                --num_in_flight;
+                ++head;
+            }
+            std::atomic_ref<unsigned>(*cq_head).store(head, std::memory_order_release);
+            #else
+            (void)wait;
+            #endif
+        }
+};
+
+
+/**
+ * @brief Run-time statistics of an asynchronous writer.
+ * @details All values are stored in atomics with a single writing thread each, such that other threads can read them for
+ * monitoring without taking any lock. The queue depth is updated by the producer, all other values are updated by the
+ * thread that writes data to disk.
+ */
+class WriterStatistics {
+    public:
+        static constexpr size_t num_latency_buckets = 24; // Number of buckets of the latency histogram, bucket k > 0 counts latencies in [2^(k-1), 2^k) microseconds, the last bucket counts all larger latencies.
+        static constexpr size_t num_summary_values = 10;  // Number of values returned by @ref GetSummary.
+
+        /**
+         * @brief Construct a new writer statistics object.
+         */
+        WriterStatistics(){ Reset(); }
+
+        /**
+         * @brief Reset all statistics.
+         * @details Must not be called concurrently with any other member function.
+         */
+        void Reset(void){
+            max_queue_depth.store(0);
+            num_batches.store(0);
+            num_bytes.store(0);
+            total_batch_ns.store(0);
+            max_batch_ns.store(0);
+            num_flushes.store(0);
+            total_flush_ns.store(0);
+            max_flush_ns.store(0);
+            num_syncs.store(0);
+            total_sync_ns.store(0);
+            max_sync_ns.store(0);
+            num_latencies.store(0);
+            total_latency_ns.store(0);
+            max_latency_ns.store(0);
+            for(auto&& bucket : latency_histogram){
+                bucket.store(0);
+            }
+            bytes_per_second.store(0.0);
+            time_of_start = std::chrono::steady_clock::now();
+            time_of_rate = time_of_start;
+            num_bytes_of_rate = 0;
+        }
+
+        /**
+         * @brief Update the maximum queue depth (producer only).
+         * @param[in] depth The current queue depth.
+         */
+        void UpdateQueueDepth(size_t depth){
+            if(depth > max_queue_depth.load(std::memory_order_relaxed)){
+                max_queue_depth.store(depth, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * @brief Add a written batch and update the throughput once per second (writer only).
+         * @param[in] numBytes Number of bytes that have been written.
+         * @param[in] durationNs Duration of the write operation in nanoseconds.
+         */
+        void AddBatch(size_t numBytes, uint64_t durationNs){
+            Add(num_batches, 1);
+            Add(num_bytes, numBytes);
+            Add(total_batch_ns, durationNs);
+            Max(max_batch_ns, durationNs);
+            auto now = std::chrono::steady_clock::now();
+            double dt = std::chrono::duration<double>(now - time_of_rate).count();
+            if(dt >= 1.0){
+                uint64_t total = num_bytes.load(std::memory_order_relaxed);
+                bytes_per_second.store(static_cast<double>(total - num_bytes_of_rate) / dt, std::memory_order_relaxed);
+                num_bytes_of_rate = total;
+                time_of_rate = now;
+            }
+        }
+
+        /**
+         * @brief Add the enqueue-to-disk latency of a sample (writer only).
+         * @param[in] latencyNs Latency in nanoseconds.
+         */
+        void AddLatency(uint64_t latencyNs){
+            Add(num_latencies, 1);
+            Add(total_latency_ns, latencyNs);
+            Max(max_latency_ns, latencyNs);
+            size_t k = 0;
+            for(uint64_t us = latencyNs / 1000; us && (k < (num_latency_buckets - 1)); us >>= 1){
+                ++k;
+            }
+            Add(latency_histogram[k], 1);
+        }
+
+        /**
+         * @brief Add the duration of a flush operation (writer only).
+         * @param[in] durationNs Duration in nanoseconds.
+         */
+        void AddFlush(uint64_t durationNs){
+            Add(num_flushes, 1);
+            Add(total_flush_ns, durationNs);
+            Max(max_flush_ns, durationNs);
+        }
+
+        /**
+         * @brief Add the duration of a synchronization to the storage device.
+         * @param[in] durationNs Duration in nanoseconds.
+         * @details Unlike the other functions, this may also be called by the housekeeping thread that closes retired ring
+         * buffers while the writer adds statistics, hence the values are updated by atomic read-modify-write operations.
+         */
+        void AddSync(uint64_t durationNs){
+            num_syncs.fetch_add(1, std::memory_order_relaxed);
+            total_sync_ns.fetch_add(durationNs, std::memory_order_relaxed);
+            uint64_t value = max_sync_ns.load(std::memory_order_relaxed);
+            while((durationNs > value) && !max_sync_ns.compare_exchange_weak(value, durationNs, std::memory_order_relaxed)){ }
+        }
+
+        /**
+         * @brief Get a summary of the statistics.
+         * @param[out] values Array of @ref num_summary_values values: bytes per second, maximum queue depth, mean latency,
+         * maximum latency, mean batch duration, maximum batch duration, mean flush duration, maximum flush duration, mean
+         * sync duration, maximum sync duration. All durations are given in seconds.
+         */
+        void GetSummary(double* values) const {
+            values[0] = bytes_per_second.load(std::memory_order_relaxed);
+            values[1] = static_cast<double>(max_queue_depth.load(std::memory_order_relaxed));
+            values[2] = Mean(total_latency_ns, num_latencies);
+            values[3] = 1e-9 * static_cast<double>(max_latency_ns.load(std::memory_order_relaxed));
+            values[4] = Mean(total_batch_ns, num_batches);
+            values[5] = 1e-9 * static_cast<double>(max_batch_ns.load(std::memory_order_relaxed));
+            values[6] = Mean(total_flush_ns, num_flushes);
+            values[7] = 1e-9 * static_cast<double>(max_flush_ns.load(std::memory_order_relaxed));
+            values[8] = Mean(total_sync_ns, num_syncs);
+            values[9] = 1e-9 * static_cast<double>(max_sync_ns.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * @brief Write all statistics to a JSON file.
+         * @param[in] jsonFile Path of the JSON file to be written.
+         */
+        void WriteJSON(std::filesystem::path jsonFile) const {
+            FILE* fp = fopen(jsonFile.string().c_str(), "w");
+            if(fp){
+                double values[num_summary_values];
+                GetSummary(values);
+                fprintf(fp, "{\n");
+                fprintf(fp, "    \"uptime_s\": %.6f,\n", std::chrono::duration<double>(std::chrono::steady_clock::now() - time_of_start).count());
+                fprintf(fp, "    \"bytes_written\": %llu,\n", static_cast<unsigned long long>(num_bytes.load()));
+                fprintf(fp, "    \"bytes_per_second\": %.3f,\n", values[0]);
+                fprintf(fp, "    \"max_queue_depth\": %llu,\n", static_cast<unsigned long long>(max_queue_depth.load()));
+                fprintf(fp, "    \"batches\": {\n");
+                fprintf(fp, "        \"count\": %llu,\n", static_cast<unsigned long long>(num_batches.load()));
+                fprintf(fp, "        \"mean_duration_s\": %.9f,\n", values[4]);
+                fprintf(fp, "        \"max_duration_s\": %.9f\n", values[5]);
+                fprintf(fp, "    },\n");
+                fprintf(fp, "    \"flushes\": {\n");
+                fprintf(fp, "        \"count\": %llu,\n", static_cast<unsigned long long>(num_flushes.load()));
+                fprintf(fp, "        \"mean_duration_s\": %.9f,\n", values[6]);
+                fprintf(fp, "        \"max_duration_s\": %.9f\n", values[7]);
+                fprintf(fp, "    },\n");
+                fprintf(fp, "    \"syncs\": {\n");
+                fprintf(fp, "        \"count\": %llu,\n", static_cast<unsigned long long>(num_syncs.load()));
+                fprintf(fp, "        \"mean_duration_s\": %.9f,\n", values[8]);
+                fprintf(fp, "        \"max_duration_s\": %.9f\n", values[9]);
+                fprintf(fp, "    },\n");
+                fprintf(fp, "    \"latency\": {\n");
+                fprintf(fp, "        \"count\": %llu,\n", static_cast<unsigned long long>(num_latencies.load()));
+                fprintf(fp, "        \"mean_s\": %.9f,\n", values[2]);
+                fprintf(fp, "        \"max_s\": %.9f,\n", values[3]);
+                fprintf(fp, "        \"histogram_upper_bounds_us\": [");
+                for(size_t k = 0; k < (num_latency_buckets - 1); ++k){
+                    fprintf(fp, "%s%llu", k ? ", " : "", 1ULL << k);
+                }
+                fprintf(fp, "],\n");
+                fprintf(fp, "        \"histogram_counts\": [");
+                for(size_t k = 0; k < num_latency_buckets; ++k){
+                    fprintf(fp, "%s%llu", k ? ", " : "", static_cast<unsigned long long>(latency_histogram[k].load()));
+                }
+                fprintf(fp, "]\n");
+                fprintf(fp, "    }\n");
+                fprintf(fp, "}\n");
+                fclose(fp);
+            }
+        }
+
+    private:
+        std::atomic<uint64_t> max_queue_depth;             // Maximum queue depth, written by the producer.
+        std::atomic<uint64_t> num_batches;                 // Number of written batches.
+        std::atomic<uint64_t> num_bytes;                   // Number of written bytes.
+        std::atomic<uint64_t> total_batch_ns;              // Total duration of all batches.
+        std::atomic<uint64_t> max_batch_ns;                // Maximum duration of a batch.
+        std::atomic<uint64_t> num_flushes;                 // Number of flush operations.
+        std::atomic<uint64_t> total_flush_ns;              // Total duration of all flush operations.
+        std::atomic<uint64_t> max_flush_ns;                // Maximum duration of a flush operation.
+        std::atomic<uint64_t> num_syncs;                   // Number of synchronizations to the storage device.
+        std::atomic<uint64_t> total_sync_ns;               // Total duration of all synchronizations.
+        std::atomic<uint64_t> max_sync_ns;                 // Maximum duration of a synchronization.
+        std::atomic<uint64_t> num_latencies;               // Number of latency measurements.
+        std::atomic<uint64_t> total_latency_ns;            // Sum of all latencies.
+        std::atomic<uint64_t> max_latency_ns;              // Maximum latency.
+        std::atomic<uint64_t> latency_histogram[num_latency_buckets]; // Histogram of latencies.
+        std::atomic<double> bytes_per_second;              // Throughput during the last interval of at least one second.
+        std::chrono::steady_clock::time_point time_of_start; // Time of the last reset.
+        std::chrono::steady_clock::time_point time_of_rate;  // Time of the last throughput update, writer only.
+        uint64_t num_bytes_of_rate;                        // Number of written bytes at the last throughput update, writer only.
+
+        static void Add(std::atomic<uint64_t>& value, uint64_t increment){ value.store(value.load(std::memory_order_relaxed) + increment, std::memory_order_relaxed); }
+        static void Max(std::atomic<uint64_t>& value, uint64_t candidate){ if(candidate > value.load(std::memory_order_relaxed)){ value.store(candidate, std::memory_order_relaxed); } }
+        static double Mean(const std::atomic<uint64_t>& total, const std::atomic<uint64_t>& count){
+            uint64_t n = count.load(std::memory_order_relaxed);
+            return n ? (1e-9 * static_cast<double>(total.load(std::memory_order_relaxed)) / static_cast<double>(n)) : 0.0;
+        }
+};
+
+
 /**
  * @brief A ring buffer that writes samples to multiple files in a circular manner.
  * @details When the end of a file is reached, it swaps to the next file and wraps around to the beginning to overwrite old data.
+ * Depending on the backend, data is either written via stdio streams or copied into memory-mapped files. Memory-mapped files
+ * always have their final size, so that other processes can map in-progress files as well.
+ *
+ * If a codec or a filter is selected, samples are collected in blocks and each block is written as a record that consists of a block
+ * header followed by the encoded payload. The headers form a block index: the first record of each file starts at offset
+ * zero, each header gives the size of its payload and the index of its first sample, and a record never crosses a file
+ * boundary. If a record does not fit into the rest of a file, the rest is filled with zeros (an invalid magic number).
+ * A reader walks the records of each file in the order of the ring, starting with the file after the writing point, and
+ * orders the blocks by their first sample. The rest of the file at the writing point contains stale records of the
+ * previous revolution and is ignored.
+ *
+ * In variable-length mode, each sample is written as a record of a little-endian uint32 length followed by that number of
+ * bytes. Records follow the same rules as blocks: they start at offset zero of each file, never cross a file boundary and
+ * the rest of a file that cannot hold the next record is filled with zeros. A length of zero therefore marks the end of a
+ * file, samples without valid bytes are not written.
  */
 class MultiFileRingBuffer {
     public:
         /**
          * @brief Construct a new multi-file ring buffer object.
          */
-        MultiFileRingBuffer(): sample_size(0), file_size(0), current_file(0), index(0) {}
+        MultiFileRingBuffer(): sample_size(0), file_size(0), file_padding(0), current_file(0), next_file(0), index(0), unflushed_bytes(0), backend(MultiFileRingBufferBackend::stdio_stream), flush_bytes(0), flush_period(0), durability(MultiFileRingBufferDurability::none), unsynced_bytes(0), sync_bytes(0), sync_period(0), staging(nullptr), staging_offset(0), staging_fill(0), statistics(nullptr), codec(MultiFileRingBufferCodec::none), filter(MultiFileRingBufferFilter::none), keyframe_interval(0), variable_length(false), block_num_samples(0), block_fill(0), num_samples_encoded(0), sample_number(0), block_timestamp(0), time_index_interval(0), time_index_countdown(0), utc_offset_ns(0), num_bytes_written(0), journal_interval(0), journal_pending(0), journal_sequence(0), journal_file(nullptr), journal(nullptr) {}
 
         /**
          * @brief Destroy the multi-file ring buffer object.
@@ -45,16 +781,64 @@ class MultiFileRingBuffer {
          * @param[in] sampleSize The size of each sample.
          * @param[in] numSamplesPerFile The number of samples per file.
          * @param[in] numFiles The number of files to store.
-         * @return True if all files were opened successfully, false otherwise.
+         * @param[in] options Additional options for the ring buffer.
+         * @return True if all files were opened (and preallocated, if requested) successfully, false otherwise.
          */
-        bool Open(const char* folder, size_t sampleSize, size_t numSamplesPerFile, size_t numFiles){
+        bool Open(const char* folder, size_t sampleSize, size_t numSamplesPerFile, size_t numFiles, const MultiFileRingBufferOptions& options = MultiFileRingBufferOptions()){
             if(!files.empty()){
                 return false; // already open
             }
             sample_size = sampleSize ? sampleSize : 1;
             file_size = numSamplesPerFile ? (numSamplesPerFile * sample_size) : sample_size;
+            codec = options.codec;
+            filter = options.filter;
+            keyframe_interval = options.keyframe_interval;
+            variable_length = options.variable_length;
+            if(variable_length){
+                if(IsBlockMode()){
+                    Close();
+                    return false;
+                }
+                file_size = (numSamplesPerFile ? numSamplesPerFile : 1) * (record_header_size + sample_size);
+            }
+            if(IsBlockMode()){
+                // a record of one block must fit into a single file, even if it has to be stored uncompressed
+                file_size = (file_size < (block_header_size + sample_size)) ? (block_header_size + sample_size) : file_size;
+                block_num_samples = options.block_num_samples ? options.block_num_samples : 1;
+                block_num_samples = ((block_header_size + block_num_samples * sample_size) > file_size) ? ((file_size - block_header_size) / sample_size) : block_num_samples;
+                block_fill = 0;
+                num_samples_encoded = 0;
+                block_raw.assign(block_num_samples * sample_size, 0);
+                block_filtered.assign((MultiFileRingBufferFilter::none != filter) ? (block_num_samples * sample_size) : 0, 0);
+                block_record.assign(block_header_size + LZ4BlockEncoder::Bound(block_num_samples * sample_size), 0);
+            }
             current_file = 0;
+            next_file = (numFiles > 1) ? 1 : 0;
             index = 0;
+            unflushed_bytes = 0;
+            backend = options.backend;
+            file_padding = 0;
+            if(MultiFileRingBufferBackend::direct_io == backend){
+                file_padding = (direct_io_block_size - (file_size % direct_io_block_size)) % direct_io_block_size;
+                staging = reinterpret_cast<uint8_t*>(std::aligned_alloc(direct_io_block_size, direct_io_staging_size));
+                staging_offset = 0;
+                staging_fill = 0;
+                if(!staging){
+                    Close();
+                    return false;
+                }
+            }
+            if((MultiFileRingBufferBackend::io_uring_async == backend) && !async_writer.Open(options.async_num_buffers, options.async_buffer_size)){
+                backend = MultiFileRingBufferBackend::stdio_stream;
+            }
+            flush_bytes = options.flush_bytes;
+            flush_period = std::chrono::milliseconds(options.flush_period_ms);
+            time_of_last_flush = std::chrono::steady_clock::now();
+            durability = options.durability;
+            unsynced_bytes = 0;
+            sync_bytes = options.sync_bytes;
+            sync_period = std::chrono::milliseconds(options.sync_period_ms);
+            time_of_last_sync = time_of_last_flush;
             numFiles = numFiles ? numFiles : 1;
 
             // create directory
@@ -67,12 +851,48 @@ class MultiFileRingBuffer {
             // create files
             for(size_t k = 0; k < numFiles; ++k){
                 std::filesystem::path filename = directory / ("buffer" + std::to_string(k) + ".dat");
-                FILE* fp = fopen(filename.string().c_str(), "w");
+                FILE* fp = OpenFile(filename);
                 if(!fp){
                     Close();
                     return false;
                 }
                 files.push_back(fp);
+                if(options.preallocate && (0 != posix_fallocate(fileno(fp), 0, static_cast<off_t>(file_size + file_padding)))){
+                    Close();
+                    return false;
+                }
+                if(MultiFileRingBufferBackend::memory_mapped == backend){
+                    uint8_t* mapping = MapFile(fp);
+                    if(!mapping){
+                        Close();
+                        return false;
+                    }
+                    mappings.push_back(mapping);
+                }
+            }
+
+            // create time index files
+            sample_number = 0;
+            time_index_interval = options.time_index_interval_samples;
+            time_index_countdown = 0;
+            utc_offset_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count() - std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            for(size_t k = 0; time_index_interval && (k < numFiles); ++k){
+                FILE* fp = fopen((directory / ("buffer" + std::to_string(k) + ".idx")).string().c_str(), "w");
+                if(!fp){
+                    Close();
+                    return false;
+                }
+                index_files.push_back(fp);
+            }
+
+            // create journal
+            num_bytes_written = 0;
+            journal_interval = options.journal_interval_samples;
+            journal_pending = 0;
+            journal_sequence = 0;
+            if(journal_interval && !OpenJournal()){
+                Close();
+                return false;
             }
             return true;
         }
@@ -82,48 +902,850 @@ class MultiFileRingBuffer {
          */
         void Close(void){
             if(!files.empty()){
+                WriteBlock();
+            }
+            if(!files.empty() && staging_fill){
+                WriteStagingBlocks(true);
+            }
+            if(!files.empty() && (MultiFileRingBufferDurability::none != durability)){
+                Sync(true);
+            }
+            async_writer.Close();
+            if(!files.empty()){
+                UpdateJournal(true);
                 WriteJSONComplete();
             }
+            ReleaseResources();
+        }
+
+        /**
+         * @brief Discard the open multi-file ring buffer and remove its directory including all files.
+         * @details Used for ring buffers that have been opened in advance but have never been written.
+         */
+        void Discard(void){
+            std::filesystem::path folder = directory;
+            ReleaseResources();
+            try{
+                if(!folder.empty()){
+                    std::filesystem::remove_all(folder);
+                }
+            }
+            catch(...){ }
+        }
+
+        /**
+         * @brief Move the directory of an open multi-file ring buffer.
+         * @param[in] folder The new absolute path of the directory.
+         * @return True if success, false otherwise.
+         * @details Open files are not affected by renaming their directory.
+         */
+        bool Rename(const char* folder){
+            std::filesystem::path newDirectory(folder);
+            try{
+                std::filesystem::rename(directory, newDirectory);
+            }
+            catch(...){
+                return false;
+            }
+            directory = newDirectory;
+            return true;
+        }
+
+        /**
+         * @brief Write a sample to the multi-file ring buffer.
+         * @param[in] sampleData The sample data to write.
+         */
+        void Write(const void* sampleData){ Write(sampleData, 1); }
+
+        /**
+         * @brief Write multiple contiguous samples to the multi-file ring buffer.
+         * @param[in] sampleData The sample data to write, consisting of numSamples samples stored one after another.
+         * @param[in] numSamples The number of samples to write.
+         * @param[in] timestamps Optional monotonic timestamps (steady clock, nanoseconds) of all samples for the time index.
+         * If this is nullptr, the current time is used.
+         * @details The data is split at file boundaries, such that each file is written with a single fwrite call per
+         * segment. Buffered data is flushed according to the flush options that have been set during @ref Open.
+         */
+        void Write(const void* sampleData, size_t numSamples, const uint64_t* timestamps = nullptr){ WriteSamples<0>(sampleData, numSamples, timestamps); }
+
+        /**
+         * @brief Write multiple contiguous samples of a sample size that is known at compile time.
+         * @tparam SampleSize Number of bytes per sample.
+         * @param[in] sampleData The sample data to write, consisting of numSamples samples stored one after another.
+         * @param[in] numSamples The number of samples to write.
+         * @param[in] timestamps Optional monotonic timestamps (steady clock, nanoseconds) of all samples for the time index.
+         * If this is nullptr, the current time is used.
+         * @details Same as @ref Write, but the sample size is a constant in all copies and filter loops of the write path. If
+         * the ring buffer has been opened with a different sample size, the samples are written by the generic @ref Write.
+         */
+        template <size_t SampleSize> void WriteFixedSize(const void* sampleData, size_t numSamples, const uint64_t* timestamps = nullptr){
+            static_assert(SampleSize > 0, "The sample size must be greater than zero!");
+            if(SampleSize != sample_size){
+                WriteSamples<0>(sampleData, numSamples, timestamps);
+                return;
+            }
+            WriteSamples<SampleSize>(sampleData, numSamples, timestamps);
+        }
+
+        /**
+         * @brief Write multiple variable-length samples to the multi-file ring buffer (variable-length mode only).
+         * @param[in] sampleData The sample data to write, consisting of numSamples slots of the sample size stored one after another.
+         * @param[in] lengths The number of valid bytes at the beginning of each slot, values greater than the sample size are limited to the sample size.
+         * @param[in] numSamples The number of samples to write.
+         * @param[in] timestamps Optional monotonic timestamps (steady clock, nanoseconds) of all samples for the time index.
+         * If this is nullptr, the current time is used.
+         * @details Each sample with at least one valid byte is written as a record. Buffered data is flushed according to
+         * the flush options that have been set during @ref Open.
+         */
+        void WriteRecords(const void* sampleData, const uint32_t* lengths, size_t numSamples, const uint64_t* timestamps = nullptr){
+            if(files.empty() || !variable_length){
+                return;
+            }
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(sampleData);
+            journal_pending += numSamples;
+            for(size_t k = 0; k < numSamples; ++k){
+                WriteLengthRecord(bytes + k * sample_size, lengths[k], timestamps ? (timestamps + k) : nullptr);
+            }
+            FinishWrite();
+        }
+
+        /**
+         * @brief Flush buffered data of the current file.
+         * @details Files that have been completed before are already flushed when wrapping around. For memory-mapped
+         * files, an asynchronous msync is scheduled for the current file, which only starts the writeback and gives no
+         * guarantee, see @ref Sync for durable data. For direct I/O, all complete blocks of the
+         * staging buffer are written, an incomplete block remains in the staging buffer until it is complete or the ring
+         * buffer is closed. For io_uring, the current staging buffer is submitted without waiting for its completion.
+         */
+        void Flush(void){
+            if(!mappings.empty()){
+                msync(mappings[current_file], file_size, MS_ASYNC);
+            }
+            else if(staging){
+                WriteStagingBlocks(false);
+            }
+            else if(MultiFileRingBufferBackend::io_uring_async == backend){
+                async_writer.Submit();
+            }
+            else if(!files.empty()){
+                fflush(files[current_file]);
+            }
+            if(!index_files.empty()){
+                fflush(index_files[current_file]);
+            }
+            unflushed_bytes = 0;
+            time_of_last_flush = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * @brief Check if the multi-file ring buffer is open.
+         * @return True if open, false otherwise.
+         */
+        bool IsOpen(void) const { return !files.empty(); }
+
+        /**
+         * @brief Check if a flush or a synchronization is due according to the flush and sync options.
+         * @return True if @ref FlushIfDue would write anything, false otherwise.
+         */
+        bool IsFlushOrSyncDue(void) const { return IsFlushRequired() || IsSyncRequired(); }
+
+        /**
+         * @brief Flush and synchronize buffered data if due, without writing new data.
+         * @details Allows periodic flush and sync deadlines to be met while no samples arrive.
+         */
+        void FlushIfDue(void){
+            if(IsOpen()){
+                FinishWrite();
+            }
+        }
+
+        /**
+         * @brief Get the directory of the multi-file ring buffer.
+         * @return Directory where files are stored, empty if not open.
+         */
+        std::filesystem::path GetDirectory(void) const { return directory; }
+
+        /**
+         * @brief Set the statistics object that records the duration of flush operations.
+         * @param[in] writerStatistics Pointer to the statistics object or nullptr to disable recording.
+         */
+        void SetStatistics(WriterStatistics* writerStatistics){ statistics = writerStatistics; }
+
+    private:
+        static constexpr size_t direct_io_block_size = 4096;     // Alignment of memory, file offsets and transfer sizes for direct I/O.
+        static constexpr size_t direct_io_staging_size = 1 << 16; // Size of the staging buffer for direct I/O, must be a multiple of the block size.
+        static constexpr size_t block_header_size = 24;          // Size of the header of a compressed block.
+        static constexpr uint32_t block_magic = 0x42465445;      // Magic number at the beginning of each block header ("ETFB").
+        static constexpr size_t record_header_size = 4;          // Size of the length prefix of a variable-length record.
+        static constexpr size_t journal_size = 4096;             // Size of the journal file.
+        static constexpr uint32_t journal_magic = 0x4A465445;    // Magic number at the beginning of the journal file ("ETFJ").
+        static constexpr size_t journal_entry_offset = 64;       // Offset of the first of two journal entries.
+        static constexpr size_t journal_entry_size = 64;         // Size of a journal entry.
+        size_t sample_size;                // Size of each sample.
+        size_t file_size;                  // Total size of a file.
+        size_t file_padding;               // Number of padding bytes at the end of each file (direct I/O only).
+        size_t current_file;               // Index to the current file in use.
+        size_t next_file;                  // Index to the file that follows the current file in the ring.
+        size_t index;                      // Current write index of a file.
+        size_t unflushed_bytes;            // Number of bytes written since the last flush.
+        MultiFileRingBufferBackend backend; // Backend that is used for writing data.
+        size_t flush_bytes;                // Number of unflushed bytes that trigger a flush, zero to flush after every write.
+        std::chrono::milliseconds flush_period; // Period after which unflushed data is flushed, zero to disable.
+        std::chrono::steady_clock::time_point time_of_last_flush; // Time of the last flush.
+        MultiFileRingBufferDurability durability; // Durability tier.
+        size_t unsynced_bytes;             // Number of bytes written since the last synchronization.
+        size_t sync_bytes;                 // Number of unsynchronized bytes that trigger a synchronization (periodic durability only).
+        std::chrono::milliseconds sync_period; // Period after which unsynchronized data is synchronized (periodic durability only).
+        std::chrono::steady_clock::time_point time_of_last_sync; // Time of the last synchronization.
+        std::vector<FILE*> files;          // File pointers of all open files.
+        std::vector<uint8_t*> mappings;    // Memory mappings of all open files (memory-mapped backend only).
+        uint8_t* staging;                  // Aligned staging buffer (direct I/O only).
+        size_t staging_offset;             // Block-aligned file offset of the first byte in the staging buffer.
+        size_t staging_fill;               // Number of valid bytes in the staging buffer.
+        AsyncFileWriter async_writer;      // Asynchronous writer (io_uring only).
+        WriterStatistics* statistics;      // Optional statistics object for recording flush durations.
+        MultiFileRingBufferCodec codec;    // Codec for compressing blocks of samples.
+        MultiFileRingBufferFilter filter;  // Filter that is applied to each block before it is compressed.
+        size_t keyframe_interval;          // Interval of additional keyframes in samples, zero if disabled.
+        bool variable_length;              // True if samples are written as variable-length records.
+        size_t block_num_samples;          // Number of samples per compressed block.
+        size_t block_fill;                 // Number of samples in the current block.
+        uint64_t num_samples_encoded;      // Number of samples that have been written in blocks, first sample of the current block.
+        std::vector<uint8_t> block_raw;    // Raw samples of the current block.
+        std::vector<uint8_t> block_filtered; // Filtered samples of the current block (filter only).
+        std::vector<uint8_t> block_record; // Block header and encoded payload of the record to be written.
+        LZ4BlockEncoder encoder;           // Encoder for the LZ4 codec.
+        uint64_t sample_number;            // Number of samples that have been passed to @ref Write (without blocks), number of written records in variable-length mode.
+        uint64_t block_timestamp;          // Monotonic timestamp of the first sample of the current block.
+        size_t time_index_interval;        // Number of samples between two time index entries, zero if the time index is disabled.
+        size_t time_index_countdown;       // Number of samples until the next sample number that is a multiple of the time index interval.
+        int64_t utc_offset_ns;             // Offset between the system clock and the steady clock in nanoseconds.
+        std::vector<FILE*> index_files;    // Time index files of all data files.
+        uint64_t num_bytes_written;        // Number of bytes that have been passed to the backend.
+        size_t journal_interval;           // Number of samples between two journal updates, zero if the journal is disabled.
+        size_t journal_pending;            // Number of samples since the last journal update.
+        uint64_t journal_sequence;         // Sequence number of the last journal entry.
+        FILE* journal_file;                // Journal file.
+        uint8_t* journal;                  // Memory mapping of the journal file.
+        std::filesystem::path directory;   // Directory where files are stored.
+
+        /**
+         * @brief Write multiple contiguous samples, see @ref Write.
+         * @tparam SampleSize Number of bytes per sample, equal to the sample size of the ring buffer, or zero to use the
+         * sample size of the ring buffer at runtime.
+         */
+        template <size_t SampleSize> void WriteSamples(const void* sampleData, size_t numSamples, const uint64_t* timestamps){
+            if(files.empty()){
+                return;
+            }
+            const size_t sampleSize = SampleSize ? SampleSize : sample_size;
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(sampleData);
+            journal_pending += numSamples;
+            if(variable_length){
+                for(size_t k = 0; k < numSamples; ++k){
+                    WriteLengthRecord(bytes + k * sampleSize, static_cast<uint32_t>(sampleSize), timestamps ? (timestamps + k) : nullptr);
+                }
+            }
+            else if(!IsBlockMode()){
+                while(numSamples){
+                    size_t n = numSamples;
+                    if(time_index_interval){
+                        if(!time_index_countdown){
+                            AddTimeIndexEntry(sample_number, timestamps ? *timestamps : Now());
+                            time_index_countdown = time_index_interval;
+                        }
+                        n = (time_index_countdown < n) ? time_index_countdown : n;
+                        time_index_countdown -= n;
+                        timestamps = timestamps ? (timestamps + n) : nullptr;
+                    }
+                    WriteBytes(bytes, n * sampleSize);
+                    bytes += n * sampleSize;
+                    numSamples -= n;
+                    sample_number += n;
+                }
+            }
+            else{
+                while(numSamples){
+                    if(!block_fill){
+                        block_timestamp = timestamps ? *timestamps : Now();
+                    }
+                    size_t n = block_num_samples - block_fill;
+                    n = (numSamples < n) ? numSamples : n;
+                    timestamps = timestamps ? (timestamps + n) : nullptr;
+                    std::memcpy(&block_raw[block_fill * sampleSize], bytes, n * sampleSize);
+                    block_fill += n;
+                    bytes += n * sampleSize;
+                    numSamples -= n;
+                    if(block_num_samples == block_fill){
+                        WriteBlock<SampleSize>();
+                    }
+                }
+            }
+            FinishWrite();
+        }
+
+        /**
+         * @brief Write a contiguous byte stream to the files.
+         * @param[in] bytes Pointer to the data.
+         * @param[in] numBytes Number of bytes to write.
+         * @details The data is split at file boundaries, such that each file is written with a single write operation per
+         * segment.
+         */
+        void WriteBytes(const uint8_t* bytes, size_t numBytes){
+            while(numBytes){
+                size_t n = file_size - index;
+                n = (numBytes < n) ? numBytes : n;
+                WriteSegment(bytes, n);
+                bytes += n;
+                numBytes -= n;
+                if(index >= file_size){
+                    NextFile();
+                }
+            }
+        }
+
+        /**
+         * @brief Write data to the current file at the current write index.
+         * @param[in] bytes Pointer to the data.
+         * @param[in] numBytes Number of bytes, must not exceed the remaining bytes of the current file.
+         */
+        void WriteSegment(const uint8_t* bytes, size_t numBytes){
+            if(MultiFileRingBufferBackend::memory_mapped == backend){
+                std::memcpy(mappings[current_file] + index, bytes, numBytes);
+            }
+            else if(MultiFileRingBufferBackend::direct_io == backend){
+                Stage(bytes, numBytes);
+            }
+            else if(MultiFileRingBufferBackend::io_uring_async == backend){
+                async_writer.Write(fileno(files[current_file]), index, bytes, numBytes);
+            }
+            else{
+                fwrite(bytes, 1, numBytes, files[current_file]);
+            }
+            unflushed_bytes += numBytes;
+            unsynced_bytes += numBytes;
+            num_bytes_written += numBytes;
+            index += numBytes;
+        }
+
+        /**
+         * @brief Complete the current file and continue with the beginning of the next file.
+         */
+        void NextFile(void){
+            if((MultiFileRingBufferBackend::memory_mapped == backend) && (MultiFileRingBufferDurability::periodic != durability)){
+                msync(mappings[current_file], file_size, MS_ASYNC); // start the writeback, the periodic tier synchronizes the file below
+            }
+            else if(MultiFileRingBufferBackend::direct_io == backend){
+                WriteStagingFileEnd();
+            }
+            else if(MultiFileRingBufferBackend::stdio_stream == backend){
+                fseek(files[current_file], 0, SEEK_SET); // also flushes the buffered data of this file
+            }
+            if(MultiFileRingBufferDurability::periodic == durability){
+                Sync(false); // the completed file is not synchronized periodically anymore
+            }
+            index = 0;
+            if(!index_files.empty()){
+                fflush(index_files[current_file]);
+                rewind(index_files[next_file]);
+                (void)ftruncate(fileno(index_files[next_file]), 0); // the entries of the previous revolution are outdated
+            }
+            current_file = next_file;
+            next_file = ((next_file + 1) < files.size()) ? (next_file + 1) : 0;
+            if((MultiFileRingBufferBackend::io_uring_async == backend) && !current_file){
+                // writes of the previous revolution must not be reordered with writes to the same file range
+                async_writer.Submit();
+                async_writer.WaitAll();
+            }
+        }
+
+        /**
+         * @brief Prepare the current file for a record that must not be split across two files.
+         * @param[in] numBytes Number of bytes of the record, must not exceed @ref file_size.
+         * @details If the record does not fit into the rest of the current file, the rest is filled with zeros and the
+         * writing point moves to the beginning of the next file.
+         */
+        void PadRecord(size_t numBytes){
+            static const uint8_t zeros[4096] = {0};
+            if(numBytes > (file_size - index)){
+                while(index < file_size){
+                    size_t n = file_size - index;
+                    WriteSegment(zeros, (n < sizeof(zeros)) ? n : sizeof(zeros));
+                }
+                NextFile();
+            }
+        }
+
+        /**
+         * @brief Write a block record that must not be split across two files.
+         * @param[in] bytes Pointer to the record.
+         * @param[in] numBytes Number of bytes of the record, must not exceed @ref file_size.
+         * @details The record is written to the beginning of the next file if it does not fit into the rest of the current
+         * file, see @ref PadRecord.
+         */
+        void WriteRecord(const uint8_t* bytes, size_t numBytes){
+            PadRecord(numBytes);
+            if(time_index_interval){
+                // add an entry for the record if it contains a multiple of the interval
+                if(time_index_countdown < block_fill){
+                    AddTimeIndexEntry(num_samples_encoded, block_timestamp);
+                    while(time_index_countdown < block_fill){
+                        time_index_countdown += time_index_interval;
+                    }
+                }
+                time_index_countdown -= block_fill;
+            }
+            WriteBytes(bytes, numBytes);
+        }
+
+        /**
+         * @brief Add an entry for the current writing point to the time index file of the current file.
+         * @param[in] sampleNumber Number of the sample at the writing point, counted from the first sample of the ring buffer.
+         * @param[in] timestamp Monotonic timestamp (steady clock, nanoseconds) of that sample.
+         * @details Each entry consists of the little-endian fields uint64 sample_number, uint64 monotonic_ns, int64 utc_ns
+         * and uint64 byte_offset. The time index file of a data file is truncated when the data file is overwritten.
+         */
+        void AddTimeIndexEntry(uint64_t sampleNumber, uint64_t timestamp){
+            int64_t entry[4];
+            entry[0] = static_cast<int64_t>(sampleNumber);
+            entry[1] = static_cast<int64_t>(timestamp);
+            entry[2] = static_cast<int64_t>(timestamp) + utc_offset_ns;
+            entry[3] = static_cast<int64_t>(index);
+            fwrite(&entry[0], sizeof(entry), 1, index_files[current_file]);
+        }
+
+        /**
+         * @brief Get the current monotonic time.
+         * @return Time of the steady clock in nanoseconds.
+         */
+        static uint64_t Now(void){
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        /**
+         * @brief Check whether samples are written in blocks.
+         * @return True if a codec or a filter is selected, false otherwise.
+         */
+        bool IsBlockMode(void) const { return (MultiFileRingBufferCodec::none != codec) || (MultiFileRingBufferFilter::none != filter); }
+
+        /**
+         * @brief Write a single variable-length sample as a record.
+         * @param[in] bytes Pointer to the sample data.
+         * @param[in] length Number of valid bytes, values greater than the sample size are limited to the sample size.
+         * @param[in] timestamp Optional monotonic timestamp of the sample for the time index, nullptr to use the current time.
+         * @details A sample without valid bytes is not written.
+         */
+        void WriteLengthRecord(const uint8_t* bytes, uint32_t length, const uint64_t* timestamp){
+            length = (length < sample_size) ? length : static_cast<uint32_t>(sample_size);
+            if(!length){
+                return;
+            }
+            PadRecord(record_header_size + length);
+            if(time_index_interval){
+                if(!time_index_countdown){
+                    AddTimeIndexEntry(sample_number, timestamp ? *timestamp : Now());
+                    time_index_countdown = time_index_interval;
+                }
+                time_index_countdown--;
+            }
+            WriteBytes(reinterpret_cast<const uint8_t*>(&length), record_header_size);
+            WriteBytes(bytes, length);
+            sample_number++;
+        }
+
+        /**
+         * @brief Flush buffered data and update the journal according to the options after data has been written.
+         */
+        void FinishWrite(void){
+            const bool synced = IsSyncRequired();
+            if(IsFlushRequired() || (synced && unflushed_bytes)){
+                auto t0 = std::chrono::steady_clock::now();
+                Flush(); // once, the sync below does not flush again
+                if(statistics){
+                    statistics->AddFlush(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count()));
+                }
+            }
+            if(synced){
+                Sync(false);
+            }
+            if(journal && (synced || (journal_pending >= journal_interval))){
+                UpdateJournal(false); // the journal follows each sync point, such that it is durable as well
+            }
+        }
+
+        /**
+         * @brief Apply the filter to the samples of the current block.
+         * @tparam SampleSize Number of bytes per sample, or zero to use the sample size of the ring buffer at runtime.
+         * @return Pointer to the filtered samples.
+         * @details All samples are filtered by a single loop over all bytes of the block that is vectorized by the
+         * compiler. Keyframes are restored from the raw samples afterwards.
+         */
+        template <size_t SampleSize = 0> const uint8_t* FilterBlock(void){
+            const size_t sampleSize = SampleSize ? SampleSize : sample_size;
+            const size_t n = block_fill * sampleSize;
+            const uint8_t* __restrict__ src = &block_raw[0];
+            uint8_t* __restrict__ dst = &block_filtered[0];
+            std::memcpy(dst, src, sampleSize);
+            if(MultiFileRingBufferFilter::xor_previous == filter){
+                for(size_t i = sampleSize; i < n; ++i){
+                    dst[i] = src[i] ^ src[i - sampleSize];
+                }
+            }
+            else{
+                for(size_t i = sampleSize; i < n; ++i){
+                    dst[i] = static_cast<uint8_t>(src[i] - src[i - sampleSize]);
+                }
+            }
+            if(keyframe_interval){
+                size_t k = (keyframe_interval - (num_samples_encoded % keyframe_interval)) % keyframe_interval;
+                for(k = k ? k : keyframe_interval; k < block_fill; k += keyframe_interval){
+                    std::memcpy(dst + k * sampleSize, src + k * sampleSize, sampleSize);
+                }
+            }
+            return dst;
+        }
+
+        /**
+         * @brief Encode the samples of the current block and write them as a single record.
+         * @details The record consists of a block header followed by the payload. If the encoded payload is not smaller
+         * than the raw samples, the raw samples are stored instead.
+         * @tparam SampleSize Number of bytes per sample, or zero to use the sample size of the ring buffer at runtime.
+         */
+        template <size_t SampleSize = 0> void WriteBlock(void){
+            if(!block_fill){
+                return;
+            }
+            size_t numRawBytes = block_fill * (SampleSize ? SampleSize : sample_size);
+            const uint8_t* source = (MultiFileRingBufferFilter::none != filter) ? FilterBlock<SampleSize>() : &block_raw[0];
+            uint8_t* payload = &block_record[block_header_size];
+            size_t numPayloadBytes = (MultiFileRingBufferCodec::lz4 == codec) ? encoder.Encode(payload, source, numRawBytes) : numRawBytes;
+            uint16_t blockCodec = static_cast<uint16_t>(codec);
+            if(numPayloadBytes >= numRawBytes){
+                std::memcpy(payload, source, numRawBytes);
+                numPayloadBytes = numRawBytes;
+                blockCodec = static_cast<uint16_t>(MultiFileRingBufferCodec::none);
+            }
+            uint8_t* header = &block_record[0];
+            uint32_t magic = block_magic;
+            uint16_t blockFilter = static_cast<uint16_t>(filter);
+            uint32_t payloadSize = static_cast<uint32_t>(numPayloadBytes);
+            uint32_t rawSize = static_cast<uint32_t>(numRawBytes);
+            std::memcpy(header + 0, &magic, 4);
+            std::memcpy(header + 4, &blockCodec, 2);
+            std::memcpy(header + 6, &blockFilter, 2);
+            std::memcpy(header + 8, &payloadSize, 4);
+            std::memcpy(header + 12, &rawSize, 4);
+            std::memcpy(header + 16, &num_samples_encoded, 8);
+            WriteRecord(header, block_header_size + numPayloadBytes);
+            num_samples_encoded += block_fill;
+            block_fill = 0;
+        }
+
+        /**
+         * @brief Check whether buffered data should be flushed according to the flush options.
+         * @return True if a flush is required, false otherwise.
+         */
+        bool IsFlushRequired(void) const {
+            if(!unflushed_bytes){
+                return false;
+            }
+            if(!flush_bytes && !flush_period.count()){
+                return true;
+            }
+            if(flush_bytes && (unflushed_bytes >= flush_bytes)){
+                return true;
+            }
+            return flush_period.count() && ((std::chrono::steady_clock::now() - time_of_last_flush) >= flush_period);
+        }
+
+        /**
+         * @brief Check whether the current file should be synchronized according to the sync options.
+         * @return True if the durability tier is periodic and the sync options require a synchronization, false otherwise.
+         */
+        bool IsSyncRequired(void) const {
+            if((MultiFileRingBufferDurability::periodic != durability) || !unsynced_bytes){
+                return false;
+            }
+            if(!sync_bytes && !sync_period.count()){
+                return true;
+            }
+            if(sync_bytes && (unsynced_bytes >= sync_bytes)){
+                return true;
+            }
+            return sync_period.count() && ((std::chrono::steady_clock::now() - time_of_last_sync) >= sync_period);
+        }
+
+        /**
+         * @brief Synchronize written data to the storage device.
+         * @param[in] allFiles True to synchronize all files, false to synchronize the current file only.
+         * @details Waits for all writes in flight (io_uring) before calling fdatasync. Data that has not been flushed yet is
+         * submitted (io_uring) or flushed from the stream buffer (stdio) first, completed files have already been flushed by
+         * @ref NextFile. Memory-mapped files are synchronized by a synchronous msync. Data in the staging buffer (direct I/O)
+         * that does not fill a complete block is not synchronized before the ring buffer is closed. The duration is added to
+         * the statistics.
+         */
+        void Sync(bool allFiles){
+            auto t0 = std::chrono::steady_clock::now();
+            if(MultiFileRingBufferBackend::io_uring_async == backend){
+                if(unflushed_bytes){
+                    async_writer.Submit();
+                }
+                async_writer.WaitAll();
+            }
+            size_t first = allFiles ? 0 : current_file;
+            size_t last = allFiles ? files.size() : (current_file + 1);
+            for(size_t k = first; k < last; ++k){
+                if(!mappings.empty()){
+                    msync(mappings[k], file_size, MS_SYNC);
+                }
+                else{
+                    if((MultiFileRingBufferBackend::stdio_stream == backend) && (k == current_file) && unflushed_bytes){
+                        fflush(files[k]);
+                    }
+                    (void)fdatasync(fileno(files[k]));
+                }
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            unsynced_bytes = 0;
+            time_of_last_sync = t1;
+            if(statistics){
+                statistics->AddSync(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+            }
+        }
+
+        /**
+         * @brief Release all resources, close all files and reset the bookkeeping without writing any data.
+         */
+        void ReleaseResources(void){
+            async_writer.Close();
+            std::free(staging);
+            staging = nullptr;
+            staging_offset = 0;
+            staging_fill = 0;
+            file_padding = 0;
             sample_size = 0;
-            file_size = 0;
             current_file = 0;
+            next_file = 0;
             index = 0;
+            unflushed_bytes = 0;
+            unsynced_bytes = 0;
+            durability = MultiFileRingBufferDurability::none;
+            for(auto&& mapping : mappings){
+                munmap(mapping, file_size);
+            }
+            mappings.clear();
+            file_size = 0;
+            backend = MultiFileRingBufferBackend::stdio_stream;
+            codec = MultiFileRingBufferCodec::none;
+            filter = MultiFileRingBufferFilter::none;
+            keyframe_interval = 0;
+            variable_length = false;
+            block_num_samples = 0;
+            block_fill = 0;
+            num_samples_encoded = 0;
+            sample_number = 0;
+            block_timestamp = 0;
+            time_index_interval = 0;
+            time_index_countdown = 0;
+            for(auto&& fp : index_files){
+                fclose(fp);
+            }
+            index_files.clear();
+            num_bytes_written = 0;
+            journal_interval = 0;
+            journal_pending = 0;
+            journal_sequence = 0;
+            if(journal){
+                munmap(journal, journal_size);
+                journal = nullptr;
+            }
+            if(journal_file){
+                fclose(journal_file);
+                journal_file = nullptr;
+            }
             for(auto&& fp : files){
                 fclose(fp);
             }
-            files.clear();
-            directory.clear();
+            files.clear();
+            directory.clear();
+        }
+
+        /**
+         * @brief Open a file for the selected backend.
+         * @param[in] filename Path of the file to be created or truncated.
+         * @return File pointer or nullptr if the file could not be opened.
+         * @details For direct I/O, the file pointer only serves as handle for the underlying file descriptor and stdio
+         * functions are never used to transfer data.
+         */
+        FILE* OpenFile(std::filesystem::path filename){
+            if(MultiFileRingBufferBackend::direct_io == backend){
+                int fd = open(filename.string().c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+                if(fd < 0){
+                    return nullptr;
+                }
+                FILE* fp = fdopen(fd, "r+");
+                if(!fp){
+                    close(fd);
+                }
+                return fp;
+            }
+            return fopen(filename.string().c_str(), (MultiFileRingBufferBackend::memory_mapped == backend) ? "w+" : "w");
+        }
+
+        /**
+         * @brief Copy data of the current file into the staging buffer and write the staging buffer if it is full.
+         * @param[in] bytes Pointer to the data.
+         * @param[in] numBytes Number of bytes, must not exceed the remaining bytes of the current file.
+         */
+        void Stage(const uint8_t* bytes, size_t numBytes){
+            while(numBytes){
+                size_t n = direct_io_staging_size - staging_fill;
+                n = (numBytes < n) ? numBytes : n;
+                std::memcpy(staging + staging_fill, bytes, n);
+                staging_fill += n;
+                bytes += n;
+                numBytes -= n;
+                if(direct_io_staging_size == staging_fill){
+                    WriteStagingBlocks(false);
+                }
+            }
+        }
+
+        /**
+         * @brief Write blocks of the staging buffer to the current file.
+         * @param[in] includeIncompleteBlock True if an incomplete last block should be written as well. The rest of that
+         * block is read from the file before, such that existing data behind the writing point is preserved.
+         * @details Written blocks are removed from the staging buffer. An incomplete block that is not written is moved to
+         * the beginning of the staging buffer.
+         */
+        void WriteStagingBlocks(bool includeIncompleteBlock){
+            int fd = fileno(files[current_file]);
+            size_t numBytes = staging_fill - (staging_fill % direct_io_block_size);
+            if(numBytes){
+                (void)pwrite(fd, staging, numBytes, static_cast<off_t>(staging_offset));
+                staging_offset += numBytes;
+                staging_fill -= numBytes;
+                std::memmove(staging, staging + numBytes, staging_fill);
+            }
+            if(includeIncompleteBlock && staging_fill){
+                uint8_t* block = staging + direct_io_block_size;
+                ssize_t numRead = pread(fd, block, direct_io_block_size, static_cast<off_t>(staging_offset));
+                size_t numExisting = (numRead > 0) ? static_cast<size_t>(numRead) : 0;
+                std::memset(block + numExisting, 0, direct_io_block_size - numExisting);
+                std::memcpy(block, staging, staging_fill);
+                (void)pwrite(fd, block, direct_io_block_size, static_cast<off_t>(staging_offset));
+            }
+        }
+
+        /**
+         * @brief Write the remaining staging buffer including the zero padding at the end of the current file.
+         */
+        void WriteStagingFileEnd(void){
+            size_t numBytes = staging_fill + ((direct_io_block_size - (staging_fill % direct_io_block_size)) % direct_io_block_size);
+            std::memset(staging + staging_fill, 0, numBytes - staging_fill);
+            if(numBytes){
+                (void)pwrite(fileno(files[current_file]), staging, numBytes, static_cast<off_t>(staging_offset));
+            }
+            staging_offset = 0;
+            staging_fill = 0;
         }
 
         /**
-         * @brief Write a sample to the multi-file ring buffer.
-         * @param[in] sampleData The sample data to write.
+         * @brief Resize a file to @ref file_size and map it into memory.
+         * @param[in] fp The file to be mapped, must be opened for reading and writing.
+         * @return Pointer to the mapped memory or nullptr if the file could not be mapped.
          */
-        void Write(const void* sampleData){
-            if(!files.empty()){
-                fwrite(sampleData, 1, sample_size, files[current_file]);
-                fflush(files[current_file]); // ensure data is written to disk
-                index = (index + sample_size) % file_size;
-                if(0 == index){
-                    fseek(files[current_file], 0, SEEK_SET);
-                    current_file = (current_file + 1) % files.size();
-                }
+        uint8_t* MapFile(FILE* fp){
+            int fd = fileno(fp);
+            if(0 != ftruncate(fd, static_cast<off_t>(file_size))){
+                return nullptr;
             }
+            void* mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            return (MAP_FAILED == mapping) ? nullptr : reinterpret_cast<uint8_t*>(mapping);
         }
 
         /**
-         * @brief Check if the multi-file ring buffer is open.
-         * @return True if open, false otherwise.
+         * @brief Create the journal file, map it into memory and write its header and an initial entry.
+         * @return True if success, false otherwise.
+         * @details The journal has a fixed size of @ref journal_size bytes. The header (offset 0) contains the layout of the
+         * ring buffer as little-endian fields: uint32 magic, uint32 version, uint64 bytes_per_sample, uint64 bytes_per_file,
+         * uint64 padding_bytes_per_file, uint64 files_per_ringbuffer, uint8 codec, uint8 filter, uint8 variable_length, uint8
+         * reserved, uint32 reserved, uint64 samples_per_block.
          */
-        bool IsOpen(void) const { return !files.empty(); }
+        bool OpenJournal(void){
+            journal_file = fopen((directory / "journal.bin").string().c_str(), "w+");
+            if(!journal_file || (0 != ftruncate(fileno(journal_file), static_cast<off_t>(journal_size)))){
+                return false;
+            }
+            void* mapping = mmap(nullptr, journal_size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(journal_file), 0);
+            if(MAP_FAILED == mapping){
+                return false;
+            }
+            journal = reinterpret_cast<uint8_t*>(mapping);
+            uint32_t version = 1;
+            uint64_t layout[5] = {sample_size, file_size, file_padding, files.size(), block_num_samples};
+            uint8_t codecFilter[8] = {static_cast<uint8_t>(codec), static_cast<uint8_t>(filter), static_cast<uint8_t>(variable_length), 0, 0, 0, 0, 0};
+            std::memcpy(journal + 0, &journal_magic, 4);
+            std::memcpy(journal + 4, &version, 4);
+            std::memcpy(journal + 8, &layout[0], 32);
+            std::memcpy(journal + 40, codecFilter, 8);
+            std::memcpy(journal + 48, &layout[4], 8);
+            UpdateJournal(false);
+            return true;
+        }
 
-    private:
-        size_t sample_size;                // Size of each sample.
-        size_t file_size;                  // Total size of a file.
-        size_t current_file;               // Index to the current file in use.
-        size_t index;                      // Current write index of a file.
-        std::vector<FILE*> files;          // File pointers of all open files.
-        std::filesystem::path directory;   // Directory where files are stored.
+        /**
+         * @brief Flush all data and record the writing point in the journal.
+         * @param[in] closing True if the ring buffer is being closed and all data has already been written.
+         * @details Entries are written alternately to two slots, each consisting of the little-endian uint64 fields
+         * sequence, file_index, byte_offset, bytes_written, samples_written and a FNV-1a checksum of the preceding fields.
+         * A reader uses the valid entry with the highest sequence number, such that an update that is torn by a crash
+         * falls back to the previous entry. The recorded writing point only covers data that has been passed to the
+         * operating system (for direct I/O: written to the device, for io_uring: completed). Data that has been written
+         * after the last journal update (at most journal_interval_samples plus the samples of one write call) may already
+         * be visible behind the recorded writing point. For blocks, samples_written counts all samples of blocks that have
+         * been passed to the backend, for variable-length records it counts all records that have been passed to the backend.
+         * For the periodic durability tier (and for the final entry of any tier except none), the data is synchronized
+         * before the entry is written and the journal is synchronized by a synchronous msync afterwards, such that the
+         * recorded writing point also survives a power loss and never points behind data that has not reached the device.
+         */
+        void UpdateJournal(bool closing){
+            if(!journal){
+                return;
+            }
+            const bool durable = closing ? (MultiFileRingBufferDurability::none != durability) : (MultiFileRingBufferDurability::periodic == durability);
+            size_t offset = index;
+            uint64_t numBytes = num_bytes_written;
+            if(!closing){
+                if(unflushed_bytes){
+                    Flush();
+                }
+                if(MultiFileRingBufferBackend::io_uring_async == backend){
+                    async_writer.WaitAll();
+                }
+                if(durable && unsynced_bytes){
+                    Sync(false); // completed files have been synchronized by NextFile
+                }
+                if(staging){
+                    offset = staging_offset;
+                    numBytes -= staging_fill;
+                }
+            }
+            uint64_t entry[6];
+            entry[0] = ++journal_sequence;
+            entry[1] = current_file;
+            entry[2] = offset;
+            entry[3] = numBytes;
+            entry[4] = IsBlockMode() ? num_samples_encoded : (variable_length ? sample_number : (numBytes / sample_size));
+            entry[5] = 14695981039346656037ULL;
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&entry[0]);
+            for(size_t i = 0; i < (5 * sizeof(uint64_t)); ++i){
+                entry[5] = (entry[5] ^ bytes[i]) * 1099511628211ULL;
+            }
+            std::memcpy(journal + journal_entry_offset + (journal_sequence & 1) * journal_entry_size, &entry[0], sizeof(entry));
+            msync(journal, journal_size, durable ? MS_SYNC : MS_ASYNC);
+            journal_pending = 0;
+        }
 
         /**
          * @brief Make a directory if it does not exist.
@@ -151,10 +1773,43 @@ class MultiFileRingBuffer {
                 fprintf(fp, "{\n");
                 fprintf(fp, "    \"bytes_per_sample\": %zu,\n", sample_size);
                 fprintf(fp, "    \"bytes_per_file\": %zu,\n", file_size);
+                fprintf(fp, "    \"padding_bytes_per_file\": %zu,\n", file_padding);
                 fprintf(fp, "    \"files_per_ringbuffer\": %zu,\n", files.size());
+                fprintf(fp, "    \"codec\": \"%s\",\n", (MultiFileRingBufferCodec::lz4 == codec) ? "lz4" : "none");
+                if(IsBlockMode()){
+                    fprintf(fp, "    \"block_layout\": {\n");
+                    fprintf(fp, "        \"samples_per_block\": %zu,\n", block_num_samples);
+                    fprintf(fp, "        \"filter\": \"%s\",\n", (MultiFileRingBufferFilter::xor_previous == filter) ? "xor_previous" : ((MultiFileRingBufferFilter::delta_previous == filter) ? "delta_previous" : "none"));
+                    fprintf(fp, "        \"keyframe_interval\": %zu,\n", keyframe_interval);
+                    fprintf(fp, "        \"header_bytes\": %zu,\n", block_header_size);
+                    fprintf(fp, "        \"header_fields\": \"uint32 magic, uint16 codec, uint16 filter, uint32 payload_bytes, uint32 raw_bytes, uint64 first_sample\",\n");
+                    fprintf(fp, "        \"magic\": %u,\n", block_magic);
+                    fprintf(fp, "        \"num_samples\": %llu\n", static_cast<unsigned long long>(num_samples_encoded));
+                    fprintf(fp, "    },\n");
+                }
+                if(variable_length){
+                    fprintf(fp, "    \"record_layout\": {\n");
+                    fprintf(fp, "        \"max_length\": %zu,\n", sample_size);
+                    fprintf(fp, "        \"header_bytes\": %zu,\n", record_header_size);
+                    fprintf(fp, "        \"header_fields\": \"uint32 length\",\n");
+                    fprintf(fp, "        \"num_records\": %llu\n", static_cast<unsigned long long>(sample_number));
+                    fprintf(fp, "    },\n");
+                }
+                if(journal){
+                    fprintf(fp, "    \"journal\": \"journal.bin\",\n");
+                }
+                if(time_index_interval){
+                    fprintf(fp, "    \"time_index\": {\n");
+                    fprintf(fp, "        \"files\": \"bufferN.idx\",\n");
+                    fprintf(fp, "        \"interval_samples\": %zu,\n", time_index_interval);
+                    fprintf(fp, "        \"entry_bytes\": 32,\n");
+                    fprintf(fp, "        \"entry_fields\": \"uint64 sample_number, uint64 monotonic_ns, int64 utc_ns, uint64 byte_offset\"\n");
+                    fprintf(fp, "    },\n");
+                }
                 fprintf(fp, "    \"writing_point\": {\n");
                 fprintf(fp, "        \"file_index\": %zu,\n", current_file);
-                fprintf(fp, "        \"byte_offset\": %zu\n", index);
+                fprintf(fp, "        \"byte_offset\": %zu,\n", index);
+                fprintf(fp, "        \"bytes_written\": %llu\n", static_cast<unsigned long long>(num_bytes_written));
                 fprintf(fp, "    }\n");
                 fprintf(fp, "}\n");
                 fclose(fp);
@@ -163,17 +1818,251 @@ class MultiFileRingBuffer {
 };
 
 
+/**
+ * @brief A lock-free single-producer/single-consumer queue of fixed-size sample slots.
+ * @details All slots are allocated once by @ref Resize. Pushing and popping samples only copies data into or out of
+ * preallocated memory, no heap memory is allocated afterwards. One thread (the producer) may call @ref Push and
+ * @ref DropOldest while another thread (the consumer) calls @ref Claim, @ref Sample, @ref Flag, @ref Contiguous and
+ * @ref Pop. The consumer first claims all available samples. Claimed slots are not touched by the producer until
+ * they have been removed by @ref Pop. @ref Resize and @ref Release must not be called concurrently with any other
+ * member function.
+ */
+class SampleQueue {
+    public:
+        /**
+         * @brief Construct a new sample queue object without any slots.
+         */
+        SampleQueue(): sample_size(0), capacity(0), head(0), read(0), tail(0), claim_begin(0) {}
+
+        /**
+         * @brief Allocate the slots of the queue and remove all samples.
+         * @param[in] sampleSize The size of each sample in bytes.
+         * @param[in] maxNumSamples The maximum number of samples that can be stored in the queue.
+         */
+        void Resize(size_t sampleSize, size_t maxNumSamples){
+            sample_size = sampleSize;
+            capacity = maxNumSamples;
+            slots.assign(sample_size * capacity, 0);
+            flags.assign(capacity, 0);
+            timestamps.assign(capacity, 0);
+            lengths.assign(capacity, 0);
+            head.store(0);
+            read.store(0);
+            tail.store(0);
+            claim_begin = 0;
+        }
+
+        /**
+         * @brief Release all slots of the queue.
+         */
+        void Release(void){
+            sample_size = 0;
+            capacity = 0;
+            head.store(0);
+            read.store(0);
+            tail.store(0);
+            claim_begin = 0;
+            std::vector<uint8_t>().swap(slots);
+            std::vector<uint8_t>().swap(flags);
+            std::vector<uint64_t>().swap(timestamps);
+            std::vector<uint32_t>().swap(lengths);
+        }
+
+        /**
+         * @brief Copy a sample into the next free slot (producer only).
+         * @param[in] sampleData Pointer to the sample data. The size must be equal to the sample size of the queue.
+         * @param[in] flag A user-defined flag to be stored together with the sample.
+         * @param[in] timestamp A user-defined timestamp to be stored together with the sample.
+         * @return True if success, false if the queue is full.
+         * @details This function is wait-free.
+         */
+        bool Push(const void* sampleData, bool flag, uint64_t timestamp){
+            uint8_t* slot = Reserve();
+            if(!slot){
+                return false;
+            }
+            std::memcpy(slot, sampleData, sample_size);
+            Commit(flag, timestamp, static_cast<uint32_t>(sample_size));
+            return true;
+        }
+
+        /**
+         * @brief Get the next free slot so that the producer can write the sample data in place (producer only).
+         * @return Pointer to the slot memory of size sample size or nullptr if the queue is full.
+         * @details This function is wait-free. The slot is not visible to the consumer until @ref Commit is called. Calling
+         * this function again without a commit returns the same slot.
+         */
+        uint8_t* Reserve(void){
+            size_t h = head.load(std::memory_order_relaxed);
+            if((h - tail.load(std::memory_order_acquire)) >= capacity){
+                return nullptr;
+            }
+            return &slots[(h % capacity) * sample_size];
+        }
+
+        /**
+         * @brief Publish the slot that has been returned by the last successful call to @ref Reserve (producer only).
+         * @param[in] flag A user-defined flag to be stored together with the sample.
+         * @param[in] timestamp A user-defined timestamp to be stored together with the sample.
+         * @param[in] length Number of valid bytes at the beginning of the slot, must not exceed the sample size.
+         * @details This function is wait-free. It must only be called after a successful @ref Reserve.
+         */
+        void Commit(bool flag, uint64_t timestamp, uint32_t length){
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t k = h % capacity;
+            flags[k] = static_cast<uint8_t>(flag);
+            timestamps[k] = timestamp;
+            lengths[k] = length;
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Remove the oldest sample from a full queue to make room for a new sample (producer only).
+         * @return True if a sample has been removed, false if the queue is not full or if the consumer currently holds a
+         * claim on the oldest sample.
+         * @details This function is lock-free.
+         */
+        bool DropOldest(void){
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t t = tail.load(std::memory_order_acquire);
+            size_t r = read.load(std::memory_order_acquire);
+            if(((h - t) < capacity) || (r != t) || (r == h)){
+                return false;
+            }
+            if(!read.compare_exchange_strong(r, r + 1, std::memory_order_acq_rel)){
+                return false; // the consumer claimed the oldest sample in the meantime
+            }
+            (void)tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel); // fails if the consumer already released newer samples
+            return true;
+        }
+
+        /**
+         * @brief Claim all samples that are available to the consumer (consumer only).
+         * @return Number of claimed samples that can be read by @ref Sample and must be removed by @ref Pop.
+         */
+        size_t Claim(void){
+            size_t r = read.load(std::memory_order_acquire);
+            size_t h;
+            do{
+                h = head.load(std::memory_order_acquire);
+            } while(!read.compare_exchange_weak(r, h, std::memory_order_acq_rel));
+            claim_begin = r;
+            return h - r;
+        }
+
+        /**
+         * @brief Get a claimed sample from the queue without removing it (consumer only).
+         * @param[in] k Position of the sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return Pointer to the sample data.
+         */
+        const uint8_t* Sample(size_t k) const { return &slots[((claim_begin + k) % capacity) * sample_size]; }
+
+        /**
+         * @brief Get the number of samples that are stored contiguously in memory starting at a given position (consumer only).
+         * @param[in] k Position of the first sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return Number of samples up to the end of the slot memory, the result may exceed the number of claimed samples.
+         */
+        size_t Contiguous(size_t k) const { return capacity - ((claim_begin + k) % capacity); }
+
+        /**
+         * @brief Get the flag of a claimed sample from the queue (consumer only).
+         * @param[in] k Position of the sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return The flag that has been pushed together with the sample.
+         */
+        bool Flag(size_t k) const { return static_cast<bool>(flags[(claim_begin + k) % capacity]); }
+
+        /**
+         * @brief Get the timestamp of a claimed sample from the queue (consumer only).
+         * @param[in] k Position of the sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return The timestamp that has been pushed together with the sample.
+         */
+        uint64_t Timestamp(size_t k) const { return timestamps[(claim_begin + k) % capacity]; }
+
+        /**
+         * @brief Get a pointer to the timestamps of claimed samples from the queue (consumer only).
+         * @param[in] k Position of the first sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return Pointer to the timestamp of the k-th claimed sample. The timestamps of @ref Contiguous samples are stored one after another.
+         */
+        const uint64_t* Timestamps(size_t k) const { return &timestamps[(claim_begin + k) % capacity]; }
+
+        /**
+         * @brief Get a pointer to the lengths of claimed samples from the queue (consumer only).
+         * @param[in] k Position of the first sample, where zero indicates the oldest claimed sample. Must be less than the number of claimed samples.
+         * @return Pointer to the number of valid bytes of the k-th claimed sample. The lengths of @ref Contiguous samples are stored one after another.
+         */
+        const uint32_t* Lengths(size_t k) const { return &lengths[(claim_begin + k) % capacity]; }
+
+        /**
+         * @brief Remove the oldest claimed samples from the queue (consumer only).
+         * @param[in] n Number of samples to remove. Must not be greater than the number of claimed samples.
+         */
+        void Pop(size_t n){
+            if(n){ // an empty claim must not overwrite a tail that has been advanced by @ref DropOldest
+                claim_begin += n;
+                tail.store(claim_begin, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief Get the number of samples in the queue.
+         * @return Number of samples.
+         * @note This can be called from any thread, the result is a snapshot of the queue depth.
+         */
+        size_t Size(void) const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Get the maximum number of samples that can be stored in the queue.
+         * @return Capacity of the queue, zero if no slots have been allocated.
+         */
+        size_t Capacity(void) const { return capacity; }
+
+    private:
+        static constexpr size_t cache_line_size = 64;      // Assumed size of a cache line to avoid false sharing of head and tail.
+        size_t sample_size;                                // Size of each sample.
+        size_t capacity;                                   // Maximum number of samples.
+        alignas(cache_line_size) std::atomic<size_t> head; // Total number of pushed samples, written by the producer.
+        alignas(cache_line_size) std::atomic<size_t> read; // Total number of claimed or dropped samples, written by the consumer and by @ref DropOldest.
+        alignas(cache_line_size) std::atomic<size_t> tail; // Total number of removed samples whose slots can be reused.
+        size_t claim_begin;                                // Position of the oldest claimed sample, consumer only.
+        alignas(cache_line_size) std::vector<uint8_t> slots; // Preallocated memory for all samples.
+        std::vector<uint8_t> flags;                        // Preallocated memory for all flags.
+        std::vector<uint64_t> timestamps;                  // Preallocated memory for all timestamps.
+        std::vector<uint32_t> lengths;                     // Preallocated memory for the number of valid bytes of all samples.
+};
+
+
+/**
+ * @brief Scheduling policy of a notifyable thread.
+ */
+enum class ThreadPolicy : uint8_t {
+    fifo = 0,                             // SCHED_FIFO with a real-time priority.
+    round_robin = 1,                      // SCHED_RR with a real-time priority.
+    other = 2                             // SCHED_OTHER, the priority is used as nice value.
+};
+
+
+/**
+ * @brief Options for starting a notifyable thread.
+ */
+struct ThreadOptions {
+    ThreadPolicy policy = ThreadPolicy::fifo; // Scheduling policy of the thread.
+    int priority = 0;                     // Real-time priority for @ref ThreadPolicy::fifo and @ref ThreadPolicy::round_robin, nice value for @ref ThreadPolicy::other.
+    std::vector<int> cpus;                // CPUs the thread may run on. If empty, the affinity is not changed.
+};
+
+
 /**
  * @brief Class representing a thread that can be notified to perform work.
  * @details This class encapsulates a thread that waits for notifications to execute a callback function.
- * It provides methods to start, stop, and notify the thread. The thread can be assigned a specific priority.
+ * It provides methods to start, stop, and notify the thread. The thread can be assigned a scheduling policy, a priority
+ * and a CPU affinity.
  */
 class NotifyableThread {
     public:
         /**
          * @brief Construct a new notifyable thread.
          */
-        NotifyableThread() : notified(false), terminate(false) {}
+        NotifyableThread() : notified(false), terminate(false), start_error(0), semNotify(0), semStarted(0) {}
 
         /**
          * @brief Destroy the notifyable thread.
@@ -186,16 +2075,31 @@ class NotifyableThread {
         /**
          * @brief Start or restart the notifyable thread.
          * @param[in] callback Callback function to be called inside the thread when it is notified.
-         * @param[in] priority Thread priority to be set using pthread_setschedparam (SCHED_FIFO).
+         * @param[in] options Scheduling policy, priority and CPU affinity of the thread.
+         * @param[in] wakeupPeriod If greater than zero, the callback is also called if the thread has not been notified
+         * within this period. This allows notifiers to skip notifications without delaying the work indefinitely.
+         * @return Zero if all options have been applied, otherwise the error number of the first operation that failed.
+         * @details The options are applied by the new thread itself before it waits for the first notification. The thread
+         * runs with the default attributes if applying an option fails.
          */
-        void Start(std::function<void(void)> callback, int priority){
+        int Start(std::function<void(void)> callback, const ThreadOptions& options, std::chrono::microseconds wakeupPeriod = std::chrono::microseconds(0)){
             Stop();
-            thread = std::thread(&NotifyableThread::WorkerThread, this, callback);
-            struct sched_param param;
-            param.sched_priority = priority;
-            if(0 != pthread_setschedparam(thread.native_handle(), SCHED_FIFO, &param)){
-                // ignore
-            }
+            start_error = 0;
+            thread = std::thread(&NotifyableThread::WorkerThread, this, callback, options, wakeupPeriod);
+            semStarted.acquire();
+            return start_error;
+        }
+
+        /**
+         * @brief Start or restart the notifyable thread with the SCHED_FIFO policy.
+         * @param[in] callback Callback function to be called inside the thread when it is notified.
+         * @param[in] priority Thread priority to be set using pthread_setschedparam (SCHED_FIFO).
+         * @return Zero if the priority has been applied, otherwise the error number.
+         */
+        int Start(std::function<void(void)> callback, int priority){
+            ThreadOptions options;
+            options.priority = priority;
+            return Start(callback, options);
         }
 
         /**
@@ -207,33 +2111,78 @@ class NotifyableThread {
             if(thread.joinable()){
                 thread.join();
             }
+            notified = false;
+            while(semNotify.try_acquire()){} // discard the notification if no thread was running
             terminate = false;
         }
 
         /**
          * @brief Notify the worker thread.
+         * @details Does not take any lock. The semaphore is only released if the worker thread has not already been notified
+         * since its last wakeup.
          */
         void Notify(void){
-            std::unique_lock<std::mutex> lock(mtxNotify);
-            notified = true;
-            cvNotify.notify_one();
+            if(!notified.exchange(true)){
+                semNotify.release();
+            }
         }
 
     private:
-        bool notified;                     // Flag for thread notification.
+        std::atomic<bool> notified;        // Flag for thread notification.
         std::atomic<bool> terminate;       // Flag for thread termination.
         std::thread thread;                // Internal worker thread.
-        std::mutex mtxNotify;              // Mutex for thread notification.
-        std::condition_variable cvNotify;  // Condition variable for thread notification.
+        int start_error;                   // Error number of applying the thread options, written by the worker thread before @ref semStarted is released.
+        std::binary_semaphore semNotify;   // Semaphore for thread notification.
+        std::binary_semaphore semStarted;  // Semaphore that is released after the thread options have been applied.
+
+        /**
+         * @brief Apply thread options to the calling thread.
+         * @param[in] options The options to be applied.
+         * @return Zero on success, otherwise the error number of the first operation that failed.
+         */
+        static int ApplyOptions(const ThreadOptions& options){
+            int result = 0;
+            if(!options.cpus.empty()){
+                cpu_set_t cpuset;
+                CPU_ZERO(&cpuset);
+                for(auto&& cpu : options.cpus){
+                    if((cpu >= 0) && (cpu < CPU_SETSIZE)){
+                        CPU_SET(cpu, &cpuset);
+                    }
+                }
+                result = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+            }
+            struct sched_param param;
+            param.sched_priority = (ThreadPolicy::other == options.policy) ? 0 : options.priority;
+            int policy = (ThreadPolicy::fifo == options.policy) ? SCHED_FIFO : ((ThreadPolicy::round_robin == options.policy) ? SCHED_RR : SCHED_OTHER);
+            int err = pthread_setschedparam(pthread_self(), policy, &param);
+            result = result ? result : err;
+            if((0 == err) && (ThreadPolicy::other == options.policy)){
+                err = setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), options.priority) ? errno : 0;
+                result = result ? result : err;
+            }
+            return result;
+        }
 
         /**
          * @brief Worker thread function.
          */
-        void WorkerThread(std::function<void(void)> callback){
+        void WorkerThread(std::function<void(void)> callback, ThreadOptions options, std::chrono::microseconds wakeupPeriod){
+            start_error = ApplyOptions(options);
+            semStarted.release();
             while(!terminate){
-                {
-                    std::unique_lock<std::mutex> lock(mtxNotify);
-                    cvNotify.wait(lock, [this](){ return (notified || terminate); });
+                // the semaphore is released once for each notification that sets the flag, the flag is only cleared
+                // together with consuming that release, such that the binary semaphore is never released twice
+                if(wakeupPeriod.count()){
+                    if(semNotify.try_acquire_for(wakeupPeriod)){
+                        notified = false;
+                    }
+                    else if(notified.exchange(false)){
+                        semNotify.acquire(); // a notification arrived after the timeout, its release is imminent
+                    }
+                }
+                else{
+                    semNotify.acquire();
                     notified = false;
                 }
                 if(terminate){
@@ -245,6 +2194,360 @@ class NotifyableThread {
 };
 
 
+/**
+ * @brief Writer service that drains several channels using a small pool of shared worker threads.
+ * @details Each channel registers a write callback and a housekeeping callback. A channel is statically assigned to the
+ * worker thread with the fewest channels, such that its write callback is never executed concurrently. Each worker thread
+ * visits its pending channels in a round-robin order that starts at a different channel on each wakeup. All housekeeping
+ * callbacks are executed by a single shared housekeeping thread. Notifying a channel does not take any lock.
+ */
+class WriterService {
+    public:
+        /**
+         * @brief A channel that is registered to the writer service.
+         */
+        struct channel {
+            std::function<void(void)> write;          // Callback to be executed by the assigned worker thread.
+            std::function<void(void)> housekeeping;   // Callback to be executed by the housekeeping thread.
+            std::function<bool(void)> due;            // Callback executed by the assigned worker thread on a periodic wakeup, true if the channel has to be written without a notification.
+            std::atomic<bool> write_pending;          // True if the write callback should be executed.
+            std::atomic<bool> housekeeping_pending;   // True if the housekeeping callback should be executed.
+            size_t worker;                            // Index of the assigned worker thread.
+            bool registered;                          // False after the channel has been unregistered, protected by both callback mutexes.
+            std::mutex mtxWrite;                      // Held while the write or due callback is running.
+            std::mutex mtxHousekeeping;               // Held while the housekeeping callback is running.
+        };
+
+        /**
+         * @brief Construct a new writer service and start all threads.
+         * @param[in] numThreads Number of worker threads, at least one thread is started.
+         * @param[in] options Thread options of the worker threads and the housekeeping thread.
+         * @param[in] wakeupPeriod If greater than zero, the worker threads additionally visit all of their channels with
+         * this period, even if they have not been notified, and write those channels that are due.
+         */
+        WriterService(size_t numThreads, const ThreadOptions& options, std::chrono::microseconds wakeupPeriod = std::chrono::microseconds(0)): round_robin(numThreads ? numThreads : 1, 0), visits(round_robin.size()), start_error(0), periodic(wakeupPeriod.count() > 0) {
+            numThreads = round_robin.size();
+            for(size_t w = 0; w < numThreads; ++w){
+                workers.push_back(std::make_unique<NotifyableThread>());
+                int err = workers.back()->Start(std::bind(&WriterService::CallbackWrite, this, w), options, wakeupPeriod);
+                start_error = start_error ? start_error : err;
+            }
+            int err = housekeeper.Start(std::bind(&WriterService::CallbackHousekeeping, this), options);
+            start_error = start_error ? start_error : err;
+        }
+
+        /**
+         * @brief Destroy the writer service.
+         * @details Stops all threads. Channels that are still registered are not drained anymore.
+         */
+        ~WriterService(){
+            for(auto&& worker : workers){
+                worker->Stop();
+            }
+            housekeeper.Stop();
+        }
+
+        /**
+         * @brief Register a new channel.
+         * @param[in] write Callback to be executed by a worker thread if the channel is notified via @ref NotifyWrite.
+         * @param[in] housekeeping Callback to be executed by the housekeeping thread if the channel is notified via @ref NotifyHousekeeping.
+         * @param[in] due Callback to be executed by the worker thread on each periodic wakeup if the channel has not been
+         * notified. The write callback is only executed if it returns true, e.g. if samples are cached or a flush deadline
+         * is due. If empty, the write callback is executed on each periodic wakeup.
+         * @return Pointer to the channel that stays valid until it is unregistered.
+         */
+        channel* Register(std::function<void(void)> write, std::function<void(void)> housekeeping, std::function<bool(void)> due = nullptr){
+            std::shared_ptr<channel> c = std::make_shared<channel>();
+            c->write = write;
+            c->housekeeping = housekeeping;
+            c->due = due;
+            c->write_pending = false;
+            c->housekeeping_pending = false;
+            c->registered = true;
+            std::vector<size_t> load(workers.size(), 0);
+            std::unique_lock<std::shared_mutex> lock(mtxChannels);
+            for(auto&& other : channels){
+                load[other->worker]++;
+            }
+            c->worker = 0;
+            for(size_t w = 1; w < load.size(); ++w){
+                c->worker = (load[w] < load[c->worker]) ? w : c->worker;
+            }
+            channels.push_back(std::move(c));
+            return channels.back().get();
+        }
+
+        /**
+         * @brief Unregister a channel.
+         * @param[in] c The channel to be unregistered.
+         * @details Waits until no callback of this channel is running. The callbacks are not executed after this function
+         * returns. Callbacks of other channels do not delay this function.
+         */
+        void Unregister(channel* c){
+            std::shared_ptr<channel> removed;
+            std::unique_lock<std::shared_mutex> lock(mtxChannels);
+            for(auto it = channels.begin(); it != channels.end(); ++it){
+                if(it->get() == c){
+                    removed = std::move(*it);
+                    channels.erase(it);
+                    break;
+                }
+            }
+            lock.unlock();
+            if(removed){
+                std::scoped_lock<std::mutex, std::mutex> callbacks(removed->mtxWrite, removed->mtxHousekeeping);
+                removed->registered = false;
+            }
+        }
+
+        /**
+         * @brief Notify the worker thread of a channel.
+         * @param[in] c The channel whose write callback should be executed.
+         */
+        void NotifyWrite(channel* c){
+            c->write_pending = true;
+            workers[c->worker]->Notify();
+        }
+
+        /**
+         * @brief Notify the housekeeping thread for a channel.
+         * @param[in] c The channel whose housekeeping callback should be executed.
+         */
+        void NotifyHousekeeping(channel* c){
+            c->housekeeping_pending = true;
+            housekeeper.Notify();
+        }
+
+        /**
+         * @brief Get the result of applying the thread options when the service has been started.
+         * @return Zero if the options have been applied to all threads, otherwise the first error number.
+         */
+        int GetStartError(void) const { return start_error; }
+
+        /**
+         * @brief Check whether the worker threads wake up periodically.
+         * @return True if a wakeup period has been specified when the service has been created.
+         */
+        bool IsPeriodic(void) const { return periodic; }
+
+        /**
+         * @brief Get the writer service of a group and create it if it does not exist.
+         * @param[in] group Identifier of the group.
+         * @param[in] numThreads Number of worker threads if the service has to be created.
+         * @param[in] options Thread options if the service has to be created.
+         * @param[in] wakeupPeriod Wakeup period of the worker threads if the service has to be created.
+         * @return Shared pointer to the writer service. The service is destroyed when the last user releases it.
+         */
+        static std::shared_ptr<WriterService> Acquire(uint32_t group, size_t numThreads, const ThreadOptions& options, std::chrono::microseconds wakeupPeriod = std::chrono::microseconds(0)){
+            static std::mutex mtxGroups;
+            static std::map<uint32_t, std::weak_ptr<WriterService>> groups;
+            std::lock_guard<std::mutex> lock(mtxGroups);
+            std::shared_ptr<WriterService> service = groups[group].lock();
+            if(!service){
+                service = std::make_shared<WriterService>(numThreads, options, wakeupPeriod);
+                groups[group] = service;
+            }
+            return service;
+        }
+
+    private:
+        std::vector<std::unique_ptr<NotifyableThread>> workers; // Worker threads that execute the write callbacks.
+        std::vector<size_t> round_robin;                  // Index of the first channel to visit for each worker thread.
+        NotifyableThread housekeeper;                     // Thread that executes the housekeeping callbacks.
+        std::vector<std::vector<std::shared_ptr<channel>>> visits; // Channels to be visited by each worker thread, copied from @ref channels.
+        std::vector<std::shared_ptr<channel>> housekeeping_visits; // Channels to be visited by the housekeeping thread, copied from @ref channels.
+        std::shared_mutex mtxChannels;                    // Shared for copying the channel list, exclusive for registration.
+        std::vector<std::shared_ptr<channel>> channels;   // All registered channels.
+        int start_error;                                  // First error of applying the thread options.
+        bool periodic;                                    // True if the worker threads wake up periodically and visit all channels.
+
+        /**
+         * @brief Callback function executed inside a worker thread when notified.
+         * @param[in] w Index of the worker thread.
+         * @details The channels of this worker are copied under the lock and written without holding it, such that
+         * registration is not delayed by a slow write. A channel is written if it has been notified or, on a periodic
+         * wakeup, if it is due.
+         */
+        void CallbackWrite(size_t w){
+            std::vector<std::shared_ptr<channel>>& visit = visits[w];
+            std::shared_lock<std::shared_mutex> lock(mtxChannels);
+            size_t n = channels.size();
+            for(size_t i = 0; i < n; ++i){
+                const std::shared_ptr<channel>& c = channels[(round_robin[w] + i) % n];
+                if(w == c->worker){
+                    visit.push_back(c);
+                }
+            }
+            round_robin[w] = n ? ((round_robin[w] + 1) % n) : 0;
+            lock.unlock();
+            for(auto&& c : visit){
+                std::lock_guard<std::mutex> guard(c->mtxWrite);
+                if(c->registered && (c->write_pending.exchange(false) || (periodic && (!c->due || c->due())))){
+                    c->write();
+                }
+            }
+            visit.clear();
+        }
+
+        /**
+         * @brief Callback function executed inside the housekeeping thread when notified.
+         * @details Like @ref CallbackWrite, the callbacks are executed without holding the lock of the channel list.
+         */
+        void CallbackHousekeeping(void){
+            std::shared_lock<std::shared_mutex> lock(mtxChannels);
+            housekeeping_visits.assign(channels.begin(), channels.end());
+            lock.unlock();
+            for(auto&& c : housekeeping_visits){
+                std::lock_guard<std::mutex> guard(c->mtxHousekeeping);
+                if(c->registered && c->housekeeping_pending.exchange(false)){
+                    c->housekeeping();
+                }
+            }
+            housekeeping_visits.clear();
+        }
+};
+
+
+/**
+ * @brief Read-only binary data of a startup file, either read into a buffer or mapped into memory.
+ * @details The data is loaded once and never modified afterwards, such that it can be shared by several startup files
+ * of the process via @ref Acquire.
+ */
+class StartupFileData {
+    public:
+        /**
+         * @brief Construct a new startup file data object without any data.
+         */
+        StartupFileData(): data(nullptr), size(0), mapping(nullptr), mapping_size(0) {}
+
+        /**
+         * @brief Destroy the startup file data object and release the buffer or the mapping.
+         */
+        ~StartupFileData(){
+            if(mapping){
+                munmap(mapping, mapping_size);
+            }
+        }
+
+        /**
+         * @brief Read or map at most maxNumBytes of a file.
+         * @param[in] filename Absolute path to the file.
+         * @param[in] maxNumBytes Maximum number of bytes to read from the file.
+         * @param[in] memoryMapped True if the file should be mapped read-only instead of being read into a buffer. Falls
+         * back to reading if the file cannot be mapped.
+         * @param[in] lockMemory True if all pages of the mapping should be prefaulted and locked in memory.
+         * @details Must be called at most once and before the data is shared. A file that cannot be read results in no data.
+         */
+        void Load(const char* filename, uint32_t maxNumBytes, bool memoryMapped, bool lockMemory){
+            if(memoryMapped && MapFile(filename, maxNumBytes, lockMemory)){
+                return;
+            }
+            std::ifstream file(filename, std::ios::binary);
+            if(file){
+                buffer.resize(maxNumBytes);
+                file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+                buffer.resize(file.gcount());
+                file.close();
+            }
+            data = buffer.data();
+            size = static_cast<uint32_t>(buffer.size());
+        }
+
+        /**
+         * @brief Get the binary data.
+         * @return Pointer to the binary data, nullptr if there is no data.
+         */
+        const uint8_t* GetData(void) const { return data; }
+
+        /**
+         * @brief Get the number of bytes of the binary data.
+         * @return Number of bytes that can be accessed via @ref GetData.
+         */
+        uint32_t GetSize(void) const { return size; }
+
+        /**
+         * @brief Get the shared data of a file and load it if it is not already loaded by another user.
+         * @param[in] filename Absolute path to the file.
+         * @param[in] maxNumBytes Maximum number of bytes to read from the file.
+         * @param[in] memoryMapped True if the file should be mapped instead of being read into a buffer.
+         * @param[in] lockMemory True if the mapping should be locked in memory.
+         * @return Shared pointer to the data. The data is released when the last user releases it.
+         * @details The data is identified by the canonical path, the size and the modification time of the file and by
+         * maxNumBytes, memoryMapped and lockMemory, such that a modified file is loaded again and users only share data that
+         * is stored the way they requested. Different files are loaded in parallel, users of the
+         * same file wait until the first user has loaded it. Files whose status cannot be obtained are not shared.
+         */
+        static std::shared_ptr<const StartupFileData> Acquire(const char* filename, uint32_t maxNumBytes, bool memoryMapped, bool lockMemory){
+            static std::mutex mtxCache;
+            static std::map<std::tuple<std::string, uint64_t, int64_t, uint32_t, bool, bool>, std::weak_ptr<StartupFileData>> cache;
+            struct stat status;
+            std::error_code err;
+            std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::path(filename), err);
+            std::shared_ptr<StartupFileData> result;
+            if(err || (0 != stat(filename, &status))){
+                result = std::make_shared<StartupFileData>();
+                result->Load(filename, maxNumBytes, memoryMapped, lockMemory);
+                return result;
+            }
+            auto key = std::make_tuple(path.string(), static_cast<uint64_t>(status.st_size), static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000LL + static_cast<int64_t>(status.st_mtim.tv_nsec), maxNumBytes, memoryMapped, memoryMapped && lockMemory);
+            std::unique_lock<std::mutex> lock(mtxCache);
+            for(auto it = cache.begin(); it != cache.end();){
+                it = it->second.expired() ? cache.erase(it) : std::next(it);
+            }
+            result = cache[key].lock();
+            if(!result){
+                result = std::make_shared<StartupFileData>();
+                cache[key] = result;
+            }
+            lock.unlock();
+            std::call_once(result->once, &StartupFileData::Load, result.get(), filename, maxNumBytes, memoryMapped, lockMemory);
+            return result;
+        }
+
+    private:
+        std::vector<uint8_t> buffer;       // Binary data that has been read from the file (not memory-mapped).
+        const uint8_t* data;               // Pointer to the binary data, either to the buffer or to the mapping.
+        uint32_t size;                     // Number of bytes of the binary data.
+        void* mapping;                     // Read-only memory mapping of the file (memory-mapped only).
+        size_t mapping_size;               // Size of the memory mapping in bytes.
+        std::once_flag once;               // Ensures that shared data is loaded exactly once.
+
+        /**
+         * @brief Map at most maxNumBytes of a file read-only into memory.
+         * @param[in] filename Absolute path to the file.
+         * @param[in] maxNumBytes Maximum number of bytes to map.
+         * @param[in] lockMemory True if all pages should be prefaulted and locked in memory.
+         * @return True if the file has been mapped, false otherwise.
+         * @details Empty files cannot be mapped and are read via the buffer. If the pages cannot be locked (e.g. due to
+         * RLIMIT_MEMLOCK), the mapping is still used, since all pages have already been populated.
+         */
+        bool MapFile(const char* filename, uint32_t maxNumBytes, bool lockMemory){
+            int fd = open(filename, O_RDONLY);
+            if(fd < 0){
+                return false;
+            }
+            struct stat status;
+            size_t numBytes = 0;
+            if(0 == fstat(fd, &status)){
+                numBytes = (static_cast<uint64_t>(status.st_size) < maxNumBytes) ? static_cast<size_t>(status.st_size) : static_cast<size_t>(maxNumBytes);
+            }
+            void* ptr = numBytes ? mmap(nullptr, numBytes, PROT_READ, MAP_PRIVATE | (lockMemory ? MAP_POPULATE : 0), fd, 0) : MAP_FAILED;
+            close(fd); // the mapping keeps a reference to the file
+            if(MAP_FAILED == ptr){
+                return false;
+            }
+            if(lockMemory){
+                (void)mlock(ptr, numBytes);
+            }
+            mapping = ptr;
+            mapping_size = numBytes;
+            data = reinterpret_cast<const uint8_t*>(ptr);
+            size = static_cast<uint32_t>(numBytes);
+            return true;
+        }
+};
+
+
 } // namespace detail
 
 
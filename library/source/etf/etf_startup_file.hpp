@@ -10,24 +10,49 @@
 
 /* Include standard libraries */
 #include <cstdint>
-#include <fstream>
+#include <cstring>
+#include <string>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <etf_detail.hpp>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 /* Default namespace for experimental target features */
 namespace etf {
 
 
+/**
+ * @brief Options for a startup file.
+ */
+struct StartupFileOptions {
+    bool memory_mapped = false;           // Map the file read-only into memory instead of reading it into a buffer. Falls back to reading if the file cannot be mapped.
+    bool lock_memory = false;             // Prefault all pages of the mapping (MAP_POPULATE) and lock them in memory (mlock), such that no page faults occur during execution (memory-mapped only).
+    bool streaming = false;               // Output the file as a sequence of slices of maxNumBytes bytes, one slice per call to @ref StartupFile::GetBytes. The file is not limited in size.
+    uint32_t stream_chunk_size = 1 << 20; // Number of bytes that are prefetched at once into each of the two chunk buffers, rounded up to a multiple of the slice size (streaming only).
+    bool shared = false;                  // Share the binary data read-only with all other startup files of this process that load the same file (same path, size and modification time) with the same maxNumBytes. The storage (buffer or mapping) is selected by the first startup file that loads the data (not streaming).
+    bool asynchronous = false;            // Load the file by a background thread, such that @ref StartupFile::Initialize does not block. The data is output as soon as it is ready.
+    detail::ThreadOptions thread_options = {detail::ThreadPolicy::other, 0, {}}; // Options of the prefetch thread (streaming) or the loader thread (asynchronous).
+};
+
+
 /**
  * @brief Startup file for reading a file during the initialization step of the real-time application and output the binary
  * data during execution.
+ * @details In streaming mode, the file is read in chunks by a prefetch thread into two chunk buffers. Each call to
+ * @ref GetBytes outputs the next slice of the current chunk buffer. As soon as a chunk buffer has been consumed, it is
+ * handed back to the prefetch thread, which refills it with the next chunk while the other chunk buffer is consumed. The
+ * memory is therefore bounded by two chunks and the slices are copied without any blocking I/O. If the prefetch thread
+ * falls behind, no data is output and the slice is output by the next call (underrun).
  */
 class StartupFile {
     public:
         /**
          * @brief Construct a new startup file object.
          */
-        StartupFile(){}
+        StartupFile(): data(nullptr), size(0), version(0), output_version(0), output_bytes(nullptr), output_max_num_bytes(0), streaming(false), stream_fd(-1), slice_size(0), stream_fill{0, 0}, stream_ready{false, false}, stream_read_index(0), stream_read_offset(0), stream_fill_index(0), stream_file_offset(0), stream_end(false), num_underruns(0), ready(false) {}
 
         /**
          * @brief Destroy the startup file object.
@@ -38,42 +63,258 @@ class StartupFile {
          * @brief Initialize the startup file.
          * @param[in] filename Absolute path to the startup file.
          * @param[in] maxNumBytes Maximum number of bytes to read from the file.
-         * @details Reads at most maxNumBytes from filename and stores them in a buffer. Use @ref GetBytes to obtain the binary data.
+         * @param[in] options Additional options for the startup file.
+         * @details Reads at most maxNumBytes from filename and stores them in a buffer or maps them into memory. Use
+         * @ref GetBytes to obtain a copy of the binary data or @ref GetData to access the binary data without copying. In
+         * streaming mode, maxNumBytes is the size of a slice and both chunk buffers are filled before this function returns.
+         * If the asynchronous option is set, the file is loaded (or the chunk buffers are filled) by a background thread
+         * and @ref IsReady indicates when the data has been published. Several startup files are loaded in parallel.
          */
-        void Initialize(const char* filename, uint32_t maxNumBytes){
-            buffer.clear();
-            std::ifstream file(filename, std::ios::binary);
-            if(file){
-                buffer.resize(maxNumBytes);
-                file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-                buffer.resize(file.gcount());
-                file.close();
+        void Initialize(const char* filename, uint32_t maxNumBytes, const StartupFileOptions& options = StartupFileOptions()){
+            Terminate();
+            ++version;
+            if(options.streaming){
+                OpenStream(filename, maxNumBytes, options);
+                return;
+            }
+            if(options.asynchronous){
+                (void)thread.Start(std::bind(&StartupFile::Load, this, std::string(filename), maxNumBytes, options), options.thread_options);
+                thread.Notify();
+                return;
             }
+            Load(filename, maxNumBytes, options);
         }
 
         /**
          * @brief Terminate the startup file.
          */
         void Terminate(void){
-            buffer.clear();
+            thread.Stop();
+            if(stream_fd >= 0){
+                close(stream_fd);
+            }
+            stream_fd = -1;
+            streaming = false;
+            slice_size = 0;
+            for(int i = 0; i < 2; ++i){
+                std::vector<uint8_t>().swap(stream_buffers[i]);
+                stream_fill[i] = 0;
+                stream_ready[i].store(false);
+            }
+            stream_read_index = 0;
+            stream_read_offset = 0;
+            stream_fill_index = 0;
+            stream_file_offset = 0;
+            stream_end = false;
+            num_underruns = 0;
+            ready.store(false);
+            file_data.reset();
+            data = nullptr;
+            size = 0;
+            output_version = 0;
+            output_bytes = nullptr;
+            output_max_num_bytes = 0;
         }
 
+        /**
+         * @brief Get the binary data without copying.
+         * @return Pointer to the binary data, nullptr if no data is available or in streaming mode. The pointer remains valid
+         * until the startup file is initialized again or terminated.
+         */
+        const uint8_t* GetData(void) const { return IsReady() ? data : nullptr; }
+
+        /**
+         * @brief Get the number of bytes that represent the actual binary data.
+         * @return Number of bytes that can be accessed via @ref GetData.
+         */
+        uint32_t GetLength(void) const { return IsReady() ? size : 0; }
+
+        /**
+         * @brief Check whether the binary data has been loaded.
+         * @return True if the data has been published (or the first chunk has been prefetched in streaming mode), false if
+         * it is still being loaded asynchronously. Files that could not be read are ready without any data.
+         * @details This function does not take any lock.
+         */
+        bool IsReady(void) const { return ready.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Get the version of the binary data.
+         * @return A number that changes whenever new binary data becomes available, e.g. after each @ref Initialize.
+         */
+        uint32_t GetVersion(void) const { return version; }
+
+        /**
+         * @brief Get the number of calls to @ref GetBytes that could not output a slice because the prefetch thread fell behind.
+         * @return Number of underruns since the last initialization (streaming only).
+         */
+        size_t GetNumUnderruns(void) const { return num_underruns; }
+
         /**
          * @brief Get bytes from the buffer.
          * @param[out] bytes Output array, where to store the binary data.
          * @param[out] length Output where to store the number of bytes that represent the actual binary data.
          * @param[in] maxNumBytes Maximum number of bytes that fit into the output array.
+         * @param[in] copyOnce True if the data should only be copied if the output array does not already contain the
+         * current data, i.e. if the data or the output array changed since the previous call. The output array must not be
+         * modified by anyone else in between.
+         * @return True if the binary data changed since the previous call, false otherwise.
+         * @details The data is copied with a single memcpy. In streaming mode, each call outputs the next slice (at most
+         * maxNumBytes bytes of it) and returns true if a slice has been output. The length is zero at the end of the file or
+         * if the next slice has not been prefetched yet.
          */
-        void GetBytes(uint8_t* bytes, uint32_t* length, uint32_t maxNumBytes){
-            if(bytes && length){
-                for(*length = 0; (*length < maxNumBytes) && (*length < static_cast<uint32_t>(buffer.size())); ++*length){
-                    bytes[*length] = buffer[*length];
-                }
+        bool GetBytes(uint8_t* bytes, uint32_t* length, uint32_t maxNumBytes, bool copyOnce = false){
+            if(!bytes || !length){
+                return false;
+            }
+            if(streaming){
+                return GetSlice(bytes, length, maxNumBytes);
+            }
+            if(!IsReady()){
+                *length = 0;
+                return false;
             }
+            bool changed = (version != output_version);
+            bool filled = !changed && (bytes == output_bytes) && (maxNumBytes == output_max_num_bytes);
+            *length = (size < maxNumBytes) ? size : maxNumBytes;
+            if(*length && (!copyOnce || !filled)){
+                std::memcpy(bytes, data, *length);
+            }
+            output_version = version;
+            output_bytes = bytes;
+            output_max_num_bytes = maxNumBytes;
+            return changed;
         }
 
     private:
-        std::vector<uint8_t> buffer;
+        std::shared_ptr<const detail::StartupFileData> file_data; // Binary data of the file, possibly shared with other startup files.
+        const uint8_t* data;                  // Pointer to the binary data of @ref file_data.
+        uint32_t size;                        // Number of bytes of the binary data.
+        uint32_t version;                     // Version of the binary data, incremented whenever new data becomes available.
+        uint32_t output_version;              // Version of the data that has been copied by the last call to @ref GetBytes, zero if none.
+        uint8_t* output_bytes;                // Output array of the last call to @ref GetBytes.
+        uint32_t output_max_num_bytes;        // Size of the output array of the last call to @ref GetBytes.
+        bool streaming;                       // True if the file is streamed in slices.
+        int stream_fd;                        // File descriptor of the streamed file.
+        uint32_t slice_size;                  // Number of bytes per slice (streaming only).
+        std::vector<uint8_t> stream_buffers[2]; // Chunk buffers, each one is owned by the prefetch thread while it is not ready.
+        size_t stream_fill[2];                // Number of valid bytes of each chunk buffer, zero indicates the end of the file.
+        std::atomic<bool> stream_ready[2];    // True if a chunk buffer has been filled and can be consumed.
+        size_t stream_read_index;             // Index of the chunk buffer that is consumed, consumer only.
+        size_t stream_read_offset;            // Offset of the next slice in the consumed chunk buffer, consumer only.
+        size_t stream_fill_index;             // Index of the chunk buffer to be filled next, prefetch thread only.
+        uint64_t stream_file_offset;          // File offset of the next chunk, prefetch thread only.
+        bool stream_end;                      // True if the end of the file has been reached, prefetch thread only.
+        size_t num_underruns;                 // Number of slices that were not available in time, consumer only.
+        std::atomic<bool> ready;              // True if the binary data has been published.
+        detail::NotifyableThread thread;      // Thread that prefetches chunks (streaming) or loads the file (asynchronous).
+
+        /**
+         * @brief Read or map the file and publish the binary data.
+         * @param[in] filename Absolute path to the startup file.
+         * @param[in] maxNumBytes Maximum number of bytes to read from the file.
+         * @param[in] options Additional options for the startup file.
+         * @details Called by @ref Initialize or by the loader thread. The consumer does not access the data before it has
+         * been published by setting @ref ready.
+         */
+        void Load(std::string filename, uint32_t maxNumBytes, StartupFileOptions options){
+            if(options.shared){
+                file_data = detail::StartupFileData::Acquire(filename.c_str(), maxNumBytes, options.memory_mapped, options.lock_memory);
+            }
+            else{
+                std::shared_ptr<detail::StartupFileData> newData = std::make_shared<detail::StartupFileData>();
+                newData->Load(filename.c_str(), maxNumBytes, options.memory_mapped, options.lock_memory);
+                file_data = newData;
+            }
+            data = file_data->GetData();
+            size = file_data->GetSize();
+            ready.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Open a file for streaming, fill both chunk buffers (unless asynchronous) and start the prefetch thread.
+         * @param[in] filename Absolute path to the startup file.
+         * @param[in] sliceSize Number of bytes per slice.
+         * @param[in] options Streaming options.
+         */
+        void OpenStream(const char* filename, uint32_t sliceSize, const StartupFileOptions& options){
+            stream_fd = open(filename, O_RDONLY);
+            if((stream_fd < 0) || !sliceSize){
+                ready.store(true, std::memory_order_release);
+                return;
+            }
+            (void)posix_fadvise(stream_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            streaming = true;
+            slice_size = sliceSize;
+            size_t numSlices = (static_cast<size_t>(options.stream_chunk_size) + slice_size - 1) / slice_size;
+            for(int i = 0; i < 2; ++i){
+                stream_buffers[i].resize((numSlices ? numSlices : 1) * slice_size);
+            }
+            if(!options.asynchronous){
+                Prefetch();
+            }
+            (void)thread.Start(std::bind(&StartupFile::Prefetch, this), options.thread_options);
+            if(options.asynchronous){
+                thread.Notify();
+            }
+        }
+
+        /**
+         * @brief Fill all chunk buffers that have been consumed with the next chunks of the file (prefetch thread only).
+         * @details The chunk buffers are filled alternately. After the last chunk, one more chunk buffer is published
+         * without any valid bytes to indicate the end of the file.
+         */
+        void Prefetch(void){
+            while(!stream_end && !stream_ready[stream_fill_index].load(std::memory_order_acquire)){
+                std::vector<uint8_t>& chunk = stream_buffers[stream_fill_index];
+                size_t fill = 0;
+                while(fill < chunk.size()){
+                    ssize_t n = pread(stream_fd, &chunk[fill], chunk.size() - fill, static_cast<off_t>(stream_file_offset + fill));
+                    if(n <= 0){
+                        break;
+                    }
+                    fill += static_cast<size_t>(n);
+                }
+                stream_file_offset += fill;
+                stream_end = !fill;
+                stream_fill[stream_fill_index] = fill;
+                stream_ready[stream_fill_index].store(true, std::memory_order_release);
+                stream_fill_index ^= 1;
+            }
+            ready.store(true, std::memory_order_release);
+        }
+
+        /**
+         * @brief Copy the next slice of the consumed chunk buffer (streaming only).
+         * @param[out] bytes Output array, where to store the slice.
+         * @param[out] length Output where to store the number of bytes of the slice.
+         * @param[in] maxNumBytes Maximum number of bytes that fit into the output array.
+         * @return True if a slice has been output, false at the end of the file or in case of an underrun.
+         */
+        bool GetSlice(uint8_t* bytes, uint32_t* length, uint32_t maxNumBytes){
+            *length = 0;
+            if(!stream_ready[stream_read_index].load(std::memory_order_acquire)){
+                num_underruns++;
+                return false;
+            }
+            const std::vector<uint8_t>& chunk = stream_buffers[stream_read_index];
+            size_t fill = stream_fill[stream_read_index];
+            if(!fill){
+                return false; // end of file
+            }
+            size_t n = fill - stream_read_offset;
+            n = (n < slice_size) ? n : slice_size;
+            *length = static_cast<uint32_t>((n < maxNumBytes) ? n : maxNumBytes);
+            std::memcpy(bytes, &chunk[stream_read_offset], *length);
+            stream_read_offset += n;
+            if(stream_read_offset >= fill){
+                stream_ready[stream_read_index].store(false, std::memory_order_release);
+                stream_read_index ^= 1;
+                stream_read_offset = 0;
+                thread.Notify();
+            }
+            ++version;
+            return true;
+        }
 };
 
 
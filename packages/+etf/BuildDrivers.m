@@ -6,6 +6,8 @@ function BuildDrivers(generateSimulinkBlocks)
     %
     % DETAILS
     % This MATLAB function generates all S-functions and compiles the corresponding mex binaries for the Simulink library.
+    % The generated C++ code of each fixed-length binary ring buffer block uses the fixed-size driver for the sample size of
+    % that block, while the mex binaries use the generic driver for all sample sizes.
 
     arguments
         generateSimulinkBlocks (1,1) logical = false
@@ -37,20 +39,57 @@ function BuildDrivers(generateSimulinkBlocks)
     % ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     % Driver: Binary Ring Buffer
     % ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    % one S-function for each combination of fixed-length or variable-length samples (additional sampleLength input) and
+    % without or with the statistics output
+    for variableLength = [false, true]
+        for statistics = [false, true]
+            variant = '';
+            outputs = 'uint8 y1[1], uint32 y2[1], uint32 y3[1], int32 y4[1]';
+            inputs  = 'uint8 u1[], uint8 u2';
+            if(variableLength)
+                variant = [variant, 'VariableLength'];
+                inputs  = [inputs, ', uint32 u3'];
+            end
+            if(statistics)
+                variant = [variant, 'Statistics'];
+                outputs = [outputs, ', double y5[10]'];
+            end
+            def = legacy_code('initialize');
+            def.SFunctionName           = ['SFunctionETFBinaryRingBuffer', variant];
+            def.StartFcnSpec            = 'void ETFDriver_BinaryRingBufferInitialize(void** work1, uint8 p1[], uint32 p2, uint32 p3, uint32 p4, uint32 p5, int32 p6, uint32 p7, uint8 p8, uint32 p9, uint32 p10, uint32 p11, uint32 p12, uint8 p13, uint32 p14[], uint32 p15, uint32 p16, uint32 p17, uint8 p18, uint8 p19, uint32 p20, uint8 p21, uint8 p22, uint32 p23, uint32 p24, uint32 p25, uint32 p26, uint8 p27, uint32 p28, uint8 p29, uint32 p30, uint32 p31, uint32 p32, uint32 p33)';
+            def.TerminateFcnSpec        = 'void ETFDriver_BinaryRingBufferTerminate(void* work1)';
+            def.OutputFcnSpec           = ['void ETFDriver_BinaryRingBufferStep', variant, '(void* work1, ', outputs, ', ', inputs, ')'];
+            def.HeaderFiles             = {'ETFDriver_BinaryRingBuffer.hpp'};
+            def.SourceFiles             = [{'ETFDriver_BinaryRingBuffer.cpp'}, sourceFiles];
+            def.IncPaths                = {'etf'};
+            def.SrcPaths                = {'etf'};
+            def.LibPaths                = {''};
+            def.HostLibFiles            = {};
+            def.Options.language        = 'C++';
+            def.Options.useTlcWithAccel = false;
+            def.SampleTime              = 'inherited';
+            defs = [defs; def];
+        end
+    end
+
+
+    % ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    % Driver: Binary Ring Buffer Reader
+    % ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     def = legacy_code('initialize');
-    def.SFunctionName           = 'SFunctionETFBinaryRingBuffer';
-    def.StartFcnSpec            = 'void ETFDriver_BinaryRingBufferInitialize(void** work1, uint8 p1[], uint32 p2, uint32 p3, uint32 p4, uint32 p5, int32 p6)';
-    def.TerminateFcnSpec        = 'void ETFDriver_BinaryRingBufferTerminate(void* work1)';
-    def.OutputFcnSpec           = 'void ETFDriver_BinaryRingBufferStep(void* work1, uint8 y1[1], uint32 y2[1], uint8 u1[], uint8 u2)';
-    def.HeaderFiles             = {'ETFDriver_BinaryRingBuffer.hpp'};
-    def.SourceFiles             = [{'ETFDriver_BinaryRingBuffer.cpp'}, sourceFiles];
+    def.SFunctionName           = 'SFunctionETFBinaryRingBufferReader';
+    def.StartFcnSpec            = 'void ETFDriver_BinaryRingBufferReaderInitialize(void** work1, uint8 p1[], uint32 p2, uint32 p4, uint8 p5, int32 p6, uint8 p7)';
+    def.TerminateFcnSpec        = 'void ETFDriver_BinaryRingBufferReaderTerminate(void* work1)';
+    def.OutputFcnSpec           = 'void ETFDriver_BinaryRingBufferReaderStep(void* work1, uint8 y1[p3], uint32 y2[1], uint8 y3[1], uint32 y4[1], uint32 p3)';
+    def.HeaderFiles             = {'ETFDriver_BinaryRingBufferReader.hpp'};
+    def.SourceFiles             = [{'ETFDriver_BinaryRingBufferReader.cpp'}, sourceFiles];
     def.IncPaths                = {'etf'};
     def.SrcPaths                = {'etf'};
     def.LibPaths                = {''};
     def.HostLibFiles            = {};
     def.Options.language        = 'C++';
     def.Options.useTlcWithAccel = false;
-    def.SampleTime              = 'inherited';
+    def.SampleTime              = 'parameterized';
     defs = [defs; def];
 
 
@@ -59,9 +98,9 @@ function BuildDrivers(generateSimulinkBlocks)
     % ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     def = legacy_code('initialize');
     def.SFunctionName           = 'SFunctionETFStartupFile';
-    def.StartFcnSpec            = 'void ETFDriver_StartupFileInitialize(void** work1, uint8 p1[], uint32 p2, uint32 p3)';
+    def.StartFcnSpec            = 'void ETFDriver_StartupFileInitialize(void** work1, uint8 p1[], uint32 p2, uint32 p3, uint8 p4, uint8 p5, uint8 p7, uint32 p8, uint8 p9, uint8 p10)';
     def.TerminateFcnSpec        = 'void ETFDriver_StartupFileTerminate(void* work1)';
-    def.OutputFcnSpec           = 'void ETFDriver_StartupFileStep(void* work1, uint8 y1[p3], uint32 y2[1], uint32 p3)';
+    def.OutputFcnSpec           = 'void ETFDriver_StartupFileStep(void* work1, uint8 y1[p3], uint32 y2[1], uint8 y3[1], uint8 y4[1], uint32 p3, uint8 p6)';
     def.HeaderFiles             = {'ETFDriver_StartupFile.hpp'};
     def.SourceFiles             = [{'ETFDriver_StartupFile.cpp'}, sourceFiles];
     def.IncPaths                = {'etf'};
@@ -92,6 +131,11 @@ function BuildDrivers(generateSimulinkBlocks)
     % generate TLC
     fprintf('\ngenerate TLC: ');
     legacy_code('sfcn_tlc_generate', defs);
+    for i = 1:numel(defs)
+        if(any(strcmp(defs(i).SFunctionName, {'SFunctionETFBinaryRingBuffer','SFunctionETFBinaryRingBufferStatistics'})))
+            UseFixedSizeDriver([defs(i).SFunctionName, '.tlc']);
+        end
+    end
     fprintf('done\n');
 
     % generate RTWMAKECFG
@@ -130,3 +174,20 @@ function sourceFiles = FindSourceFiles()
     end
 end
 
+function UseFixedSizeDriver(tlcFile)
+    % Let the generated C++ code of a fixed-length binary ring buffer block call the fixed-size driver functions with the
+    % sample size (parameter P3) of the block as template argument. The generated C code keeps the generic driver.
+    code = fileread(tlcFile);
+    fixedSize = [newline, ...
+        '  %% fixed-size driver for the sample size of this block (C++ code only), see etf.BuildDrivers', newline, ...
+        '  %assign etfFixedSize = ""', newline, ...
+        '  %if ::GenCPP == 1', newline, ...
+        '    %assign etfSampleSize = CAST("Number", LibBlockParameterValue(P3, 0))', newline, ...
+        '    %assign etfFixedSize = "FixedSize<%<etfSampleSize>>"', newline, ...
+        '  %endif'];
+    code = regexprep(code, '(%function \w+\(block, system\)[^\n]*)', ['$1', fixedSize]);
+    code = regexprep(code, '(ETFDriver_BinaryRingBuffer(Initialize|Terminate|Step|StepStatistics))\(', '$1%<etfFixedSize>(');
+    fid = fopen(tlcFile, 'w');
+    fwrite(fid, code);
+    fclose(fid);
+end
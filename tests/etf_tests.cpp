@@ -0,0 +1,952 @@
+/**
+ * @file etf_tests.cpp
+ * @brief Native behaviour checks for the experimental target features.
+ * @details Runs without MATLAB/Simulink and is registered with CTest, one test per check. Usage:
+ *
+ *     etf_tests <check> [--directory <dir>]
+ *
+ * check        One of lz4_round_trip, reader_replay, journal_recovery, sample_queue, direct_io, io_uring, variable_length,
+ *              time_index, writer_service or startup_file.
+ * --directory  Scratch directory for ring buffer files (default: system temporary directory).
+ *
+ * The exit code is zero if the check passed. Each failed expectation is reported to stderr.
+ */
+
+
+/* Include standard libraries */
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/* Include etf headers */
+#include <etf_binary_ring_buffer.hpp>
+#include <etf_binary_ring_buffer_reader.hpp>
+#include <etf_startup_file.hpp>
+
+
+/**
+ * @brief Report a failed expectation.
+ * @param[in] condition The expectation.
+ * @param[in] what Description of the expectation.
+ * @return The value of condition.
+ */
+static bool Expect(bool condition, const std::string& what){
+    if(!condition){
+        fprintf(stderr, "FAILED: %s\n", what.c_str());
+    }
+    return condition;
+}
+
+
+/**
+ * @brief Generate the test sample with a given sample number.
+ * @param[out] bytes The sample of sampleSize bytes.
+ * @param[in] sampleSize Size of the sample in bytes, at least 8.
+ * @param[in] sampleNumber The sample number, stored in the first 8 bytes.
+ * @details The remaining bytes change slowly with the sample number, such that blocks are compressible with and without a filter.
+ */
+static void MakeSample(uint8_t* bytes, size_t sampleSize, uint64_t sampleNumber){
+    std::memcpy(bytes, &sampleNumber, sizeof(sampleNumber));
+    for(size_t i = sizeof(sampleNumber); i < sampleSize; ++i){
+        bytes[i] = static_cast<uint8_t>((sampleNumber / 16) + i);
+    }
+}
+
+
+/**
+ * @brief Write samples to a multi-file ring buffer and close it.
+ * @param[in] folder Ring buffer directory.
+ * @param[in] sampleSize Size of each sample in bytes.
+ * @param[in] numSamplesPerFile Number of samples per file.
+ * @param[in] numFiles Number of files.
+ * @param[in] numSamples Number of samples to be written, generated by @ref MakeSample.
+ * @param[in] options Options of the ring buffer.
+ * @return True if the ring buffer has been opened, false otherwise.
+ * @details Samples are written in batches of varying size to cover partial blocks.
+ */
+static bool WriteRingBuffer(std::filesystem::path folder, size_t sampleSize, size_t numSamplesPerFile, size_t numFiles, uint64_t numSamples, const etf::detail::MultiFileRingBufferOptions& options){
+    etf::detail::MultiFileRingBuffer ringBuffer;
+    if(!ringBuffer.Open(folder.string().c_str(), sampleSize, numSamplesPerFile, numFiles, options)){
+        return false;
+    }
+    std::vector<uint8_t> batch(sampleSize * 7);
+    for(uint64_t n = 0; n < numSamples;){
+        size_t batchSize = 1 + static_cast<size_t>(n % 7);
+        if(batchSize > (numSamples - n)){
+            batchSize = static_cast<size_t>(numSamples - n);
+        }
+        for(size_t k = 0; k < batchSize; ++k){
+            MakeSample(&batch[k * sampleSize], sampleSize, n + k);
+        }
+        ringBuffer.Write(&batch[0], batchSize);
+        n += batchSize;
+    }
+    ringBuffer.Close();
+    return true;
+}
+
+
+/**
+ * @brief Get the length of the variable-length record with a given sample number.
+ * @param[in] sampleNumber The sample number.
+ * @param[in] sampleSize Maximum length of a record in bytes, at least 8.
+ * @return Number of valid bytes of the record, at least 8, such that the sample number is stored completely.
+ */
+static uint32_t RecordLength(uint64_t sampleNumber, size_t sampleSize){
+    return static_cast<uint32_t>(sizeof(sampleNumber) + ((sampleNumber * 7) % (sampleSize - sizeof(sampleNumber) + 1)));
+}
+
+
+/**
+ * @brief Get the ring buffer directories that have been created by a binary ring buffer.
+ * @param[in] folder Data folder of the binary ring buffer.
+ * @return All ring buffer directories sorted by name, directories that have been opened in advance are ignored.
+ */
+static std::vector<std::filesystem::path> FindRingDirectories(std::filesystem::path folder){
+    std::vector<std::filesystem::path> directories;
+    std::error_code ec;
+    for(auto&& entry : std::filesystem::directory_iterator(folder, ec)){
+        if(entry.is_directory() && (0 != entry.path().filename().string().rfind(".pending_", 0))){
+            directories.push_back(entry.path());
+        }
+    }
+    std::sort(directories.begin(), directories.end());
+    return directories;
+}
+
+
+/**
+ * @brief Wait until a condition holds.
+ * @param[in] condition The condition to be polled.
+ * @return True if the condition holds, false if it did not hold within ten seconds.
+ */
+static bool WaitUntil(std::function<bool(void)> condition){
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while(!condition()){
+        if(std::chrono::steady_clock::now() > deadline){
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+
+/**
+ * @brief Replay a ring buffer directory and compare all samples with the generated samples.
+ * @param[in] folder Ring buffer directory.
+ * @param[in] sampleSize Size of each sample in bytes.
+ * @param[in] firstSample Expected sample number of the oldest sample, or UINT64_MAX if only the order is checked.
+ * @param[in] lastSample Expected sample number of the newest sample.
+ * @param[in] what Description of the ring buffer for error messages.
+ * @param[in] variableLength True if the samples have been written as records of @ref RecordLength bytes.
+ * @return True if all samples have been replayed in order, false otherwise.
+ */
+static bool ExpectReplay(std::filesystem::path folder, size_t sampleSize, uint64_t firstSample, uint64_t lastSample, const std::string& what, bool variableLength = false){
+    etf::BinaryRingBufferReader reader;
+    if(!Expect(reader.Initialize(folder.string().c_str(), 64), what + ": reader initializes")){
+        return false;
+    }
+    std::vector<uint8_t> sample(sampleSize + 1);
+    std::vector<uint8_t> expected(sampleSize);
+    uint64_t numSamples = 0, previous = 0, first = 0;
+    bool ok = true;
+    while(ok && !reader.IsEndOfData()){
+        uint32_t length = reader.ReadSample(&sample[0], static_cast<uint32_t>(sample.size()));
+        if(!length){
+            std::this_thread::yield();
+            continue;
+        }
+        uint64_t sampleNumber;
+        std::memcpy(&sampleNumber, &sample[0], sizeof(sampleNumber));
+        MakeSample(&expected[0], sampleSize, sampleNumber);
+        const uint32_t expectedLength = variableLength ? RecordLength(sampleNumber, sampleSize) : static_cast<uint32_t>(sampleSize);
+        ok = Expect(length == expectedLength, what + ": sample " + std::to_string(sampleNumber) + " has " + std::to_string(length) + " bytes, expected " + std::to_string(expectedLength))
+          && Expect(0 == std::memcmp(&sample[0], &expected[0], expectedLength), what + ": sample " + std::to_string(sampleNumber) + " is intact")
+          && Expect(!numSamples || (sampleNumber == (previous + 1)), what + ": sample " + std::to_string(sampleNumber) + " follows " + std::to_string(previous));
+        first = numSamples ? first : sampleNumber;
+        previous = sampleNumber;
+        ++numSamples;
+    }
+    ok = ok && Expect(numSamples > 0, what + ": samples are replayed");
+    ok = ok && Expect((UINT64_MAX == firstSample) || (first == firstSample), what + ": oldest sample is " + std::to_string(first) + ", expected " + std::to_string(firstSample));
+    ok = ok && Expect(previous == lastSample, what + ": newest sample is " + std::to_string(previous) + ", expected " + std::to_string(lastSample));
+    ok = ok && Expect(reader.GetNumSamplesRead() == numSamples, what + ": number of samples read");
+    return ok;
+}
+
+
+/**
+ * @brief Check the LZ4 block codec and the block filters by a round trip through the writer and the reader.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckLZ4RoundTrip(std::filesystem::path directory){
+    bool ok = true;
+
+    // encoder and decoder, including incompressible data and a wrong decoded size
+    std::vector<uint8_t> raw(20000);
+    uint32_t state = 1;
+    for(size_t i = 0; i < raw.size(); ++i){
+        state = state * 1664525u + 1013904223u;
+        raw[i] = (i < (raw.size() / 2)) ? static_cast<uint8_t>(i / 100) : static_cast<uint8_t>(state >> 24);
+    }
+    etf::detail::LZ4BlockEncoder encoder;
+    for(size_t numBytes : {size_t(0), size_t(1), size_t(12), size_t(13), size_t(1000), raw.size() / 2, raw.size()}){
+        std::vector<uint8_t> encoded(etf::detail::LZ4BlockEncoder::Bound(numBytes));
+        std::vector<uint8_t> decoded(numBytes + 1);
+        size_t encodedSize = encoder.Encode(&encoded[0], &raw[0], numBytes);
+        const std::string what = "lz4 with " + std::to_string(numBytes) + " bytes";
+        ok = Expect(encodedSize <= encoded.size(), what + ": encoded size within bound") && ok;
+        ok = Expect(etf::detail::LZ4BlockDecoder::Decode(&decoded[0], numBytes, &encoded[0], encodedSize), what + ": decodes") && ok;
+        ok = Expect(0 == std::memcmp(&decoded[0], &raw[0], numBytes), what + ": decoded data matches") && ok;
+        ok = Expect(!numBytes || !etf::detail::LZ4BlockDecoder::Decode(&decoded[0], numBytes + 1, &encoded[0], encodedSize), what + ": wrong decoded size is rejected") && ok;
+    }
+
+    // blocks written by the ring buffer for all combinations of codec and filter
+    const etf::detail::MultiFileRingBufferCodec codecs[] = {etf::detail::MultiFileRingBufferCodec::none, etf::detail::MultiFileRingBufferCodec::lz4};
+    const etf::detail::MultiFileRingBufferFilter filters[] = {etf::detail::MultiFileRingBufferFilter::none, etf::detail::MultiFileRingBufferFilter::xor_previous, etf::detail::MultiFileRingBufferFilter::delta_previous};
+    const char* filterNames[] = {"none", "xor_previous", "delta_previous"};
+    for(auto codec : codecs){
+        for(size_t f = 0; f < 3; ++f){
+            if((etf::detail::MultiFileRingBufferCodec::none == codec) && (etf::detail::MultiFileRingBufferFilter::none == filters[f])){
+                continue; // no block mode
+            }
+            for(size_t keyframeInterval : {size_t(0), size_t(10)}){
+                etf::detail::MultiFileRingBufferOptions options;
+                options.codec = codec;
+                options.filter = filters[f];
+                options.keyframe_interval = keyframeInterval;
+                options.block_num_samples = 64;
+                std::string name = std::string((etf::detail::MultiFileRingBufferCodec::lz4 == codec) ? "lz4" : "none") + "_" + filterNames[f] + "_" + std::to_string(keyframeInterval);
+                std::filesystem::path folder = directory / name;
+                const uint64_t numSamples = 1001;
+                ok = Expect(WriteRingBuffer(folder, 24, 4096, 2, numSamples, options), name + ": ring buffer opens") && ok;
+                ok = ExpectReplay(folder, 24, 0, numSamples - 1, name) && ok;
+            }
+        }
+    }
+    return ok;
+}
+
+
+/**
+ * @brief Check that a closed ring buffer is replayed by the reader in the order in which the samples have been written.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckReaderReplay(std::filesystem::path directory){
+    bool ok = true;
+    const etf::detail::MultiFileRingBufferBackend backends[] = {etf::detail::MultiFileRingBufferBackend::stdio_stream, etf::detail::MultiFileRingBufferBackend::memory_mapped};
+    const char* backendNames[] = {"stdio_stream", "memory_mapped"};
+    const size_t numSamplesPerFile = 100, numFiles = 3;
+    for(size_t b = 0; b < 2; ++b){
+        // numSamples: not wrapped, exactly full, wrapped in the middle of a file
+        for(uint64_t numSamples : {uint64_t(150), uint64_t(300), uint64_t(1234)}){
+            etf::detail::MultiFileRingBufferOptions options;
+            options.backend = backends[b];
+            std::string name = std::string(backendNames[b]) + "_" + std::to_string(numSamples);
+            std::filesystem::path folder = directory / name;
+            const uint64_t capacity = numSamplesPerFile * numFiles;
+            ok = Expect(WriteRingBuffer(folder, 16, numSamplesPerFile, numFiles, numSamples, options), name + ": ring buffer opens") && ok;
+            ok = ExpectReplay(folder, 16, (numSamples > capacity) ? (numSamples - capacity) : 0, numSamples - 1, name) && ok;
+        }
+    }
+
+    // wrapped blocks: stale blocks behind the writing point must not be replayed
+    etf::detail::MultiFileRingBufferOptions options;
+    options.codec = etf::detail::MultiFileRingBufferCodec::lz4;
+    options.filter = etf::detail::MultiFileRingBufferFilter::xor_previous;
+    options.block_num_samples = 32;
+    ok = Expect(WriteRingBuffer(directory / "lz4_wrapped", 16, numSamplesPerFile, numFiles, 5000, options), "lz4_wrapped: ring buffer opens") && ok;
+    ok = ExpectReplay(directory / "lz4_wrapped", 16, UINT64_MAX, 4999, "lz4_wrapped") && ok;
+
+    // the reader rejects a directory without a complete.json
+    etf::BinaryRingBufferReader reader;
+    std::filesystem::create_directories(directory / "empty");
+    ok = Expect(!reader.Initialize((directory / "empty").string().c_str()), "empty: reader rejects a directory without complete.json") && ok;
+    return ok;
+}
+
+
+/**
+ * @brief Recover the writing point from a journal file without scanning the ring buffer files.
+ * @param[in] folder Ring buffer directory.
+ * @param[in] entry The valid journal entry with the highest sequence number (sequence, file_index, byte_offset, bytes_written, samples_written, checksum).
+ * @param[out] layout The layout from the journal header (bytes_per_sample, bytes_per_file, padding_bytes_per_file, files_per_ringbuffer).
+ * @return True if the journal contains a valid entry, false otherwise.
+ */
+static bool ReadJournal(std::filesystem::path folder, uint64_t (&entry)[6], uint64_t (&layout)[4]){
+    uint8_t journal[4096];
+    FILE* fp = fopen((folder / "journal.bin").string().c_str(), "rb");
+    if(!fp){
+        return false;
+    }
+    size_t n = fread(journal, 1, sizeof(journal), fp);
+    fclose(fp);
+    uint32_t magic;
+    std::memcpy(&magic, journal, 4);
+    if((sizeof(journal) != n) || (0x4A465445 != magic)){
+        return false;
+    }
+    std::memcpy(&layout[0], journal + 8, sizeof(layout));
+    bool found = false;
+    for(size_t slot = 0; slot < 2; ++slot){
+        uint64_t candidate[6];
+        std::memcpy(&candidate[0], journal + 64 + slot * 64, sizeof(candidate));
+        uint64_t checksum = 14695981039346656037ULL;
+        for(size_t i = 0; i < (5 * sizeof(uint64_t)); ++i){
+            checksum = (checksum ^ journal[64 + slot * 64 + i]) * 1099511628211ULL;
+        }
+        if((checksum == candidate[5]) && (!found || (candidate[0] > entry[0]))){
+            std::memcpy(&entry[0], &candidate[0], sizeof(candidate));
+            found = true;
+        }
+    }
+    return found;
+}
+
+
+/**
+ * @brief Check that the journal records a valid writing point if the process terminates without closing the ring buffer.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckJournalRecovery(std::filesystem::path directory){
+    bool ok = true;
+    const etf::detail::MultiFileRingBufferBackend backends[] = {etf::detail::MultiFileRingBufferBackend::stdio_stream, etf::detail::MultiFileRingBufferBackend::memory_mapped};
+    const char* backendNames[] = {"stdio_stream", "memory_mapped"};
+    const size_t sampleSize = 8, numSamplesPerFile = 1000, numFiles = 4, journalInterval = 500;
+    for(size_t b = 0; b < 2; ++b){
+        for(uint64_t numSamples : {uint64_t(2345), uint64_t(9876)}){
+            std::string name = std::string("journal_") + backendNames[b] + "_" + std::to_string(numSamples);
+            std::filesystem::path folder = directory / name;
+
+            // the child process writes samples and terminates without closing the ring buffer
+            fflush(nullptr);
+            pid_t pid = fork();
+            if(!pid){
+                etf::detail::MultiFileRingBufferOptions options;
+                options.backend = backends[b];
+                options.flush_bytes = 1 << 20;
+                options.journal_interval_samples = journalInterval;
+                etf::detail::MultiFileRingBuffer* ringBuffer = new etf::detail::MultiFileRingBuffer();
+                if(!ringBuffer->Open(folder.string().c_str(), sampleSize, numSamplesPerFile, numFiles, options)){
+                    _exit(1);
+                }
+                for(uint64_t n = 0; n < numSamples; ++n){
+                    ringBuffer->Write(&n);
+                }
+                _exit(0);
+            }
+            int status = 0;
+            ok = Expect((pid > 0) && (pid == waitpid(pid, &status, 0)) && WIFEXITED(status) && !WEXITSTATUS(status), name + ": writer process succeeds") && ok;
+            ok = Expect(!std::filesystem::exists(folder / "complete.json"), name + ": no complete.json after a crash") && ok;
+
+            // the writing point is taken from the journal and the samples in front of it are intact
+            uint64_t entry[6] = {0}, layout[4] = {0};
+            if(!Expect(ReadJournal(folder, entry, layout), name + ": journal contains a valid entry")){
+                ok = false;
+                continue;
+            }
+            const uint64_t fileIndex = entry[1], byteOffset = entry[2], numBytesWritten = entry[3], numSamplesWritten = entry[4];
+            ok = Expect((sampleSize == layout[0]) && ((sampleSize * numSamplesPerFile) == layout[1]) && (numFiles == layout[3]), name + ": journal header contains the layout") && ok;
+            ok = Expect((numSamplesWritten <= numSamples) && ((numSamplesWritten + journalInterval) >= numSamples), name + ": journal lags by at most the journal interval (" + std::to_string(numSamplesWritten) + " of " + std::to_string(numSamples) + ")") && ok;
+            ok = Expect((numSamplesWritten * sampleSize) == numBytesWritten, name + ": bytes written match samples written") && ok;
+            ok = Expect((fileIndex < numFiles) && (byteOffset <= layout[1]) && (((fileIndex * layout[1] + byteOffset) % (numFiles * layout[1])) == (numBytesWritten % (numFiles * layout[1]))), name + ": writing point matches bytes written") && ok;
+            std::vector<std::vector<uint8_t>> files(numFiles);
+            for(size_t k = 0; k < numFiles; ++k){
+                std::error_code ec;
+                std::filesystem::path filename = folder / ("buffer" + std::to_string(k) + ".dat");
+                files[k].resize(std::filesystem::exists(filename, ec) ? static_cast<size_t>(std::filesystem::file_size(filename, ec)) : 0);
+                FILE* fp = fopen(filename.string().c_str(), "rb");
+                if(fp){
+                    files[k].resize(fread(files[k].data(), 1, files[k].size(), fp));
+                    fclose(fp);
+                }
+            }
+            // samples written after the last journal update may already have overwritten the oldest samples
+            const uint64_t numRecoverable = (numSamplesWritten < (numFiles * numSamplesPerFile - journalInterval)) ? numSamplesWritten : (numFiles * numSamplesPerFile - journalInterval);
+            uint64_t file = fileIndex, offset = byteOffset;
+            bool intact = true;
+            for(uint64_t k = 0; intact && (k < numRecoverable); ++k){
+                if(!offset){
+                    file = (file + numFiles - 1) % numFiles;
+                    offset = layout[1];
+                }
+                offset -= sampleSize;
+                uint64_t value = UINT64_MAX;
+                if((offset + sampleSize) <= files[file].size()){
+                    std::memcpy(&value, &files[file][offset], sizeof(value));
+                }
+                intact = Expect(value == (numSamplesWritten - 1 - k), name + ": sample " + std::to_string(k) + " in front of the writing point is " + std::to_string(value) + ", expected " + std::to_string(numSamplesWritten - 1 - k));
+            }
+            ok = intact && ok;
+        }
+    }
+
+    // the final entry of a closed ring buffer covers all samples
+    etf::detail::MultiFileRingBufferOptions options;
+    options.journal_interval_samples = journalInterval;
+    ok = Expect(WriteRingBuffer(directory / "journal_closed", sampleSize, numSamplesPerFile, numFiles, 1234, options), "journal_closed: ring buffer opens") && ok;
+    uint64_t entry[6] = {0}, layout[4] = {0};
+    ok = Expect(ReadJournal(directory / "journal_closed", entry, layout) && (1234 == entry[4]) && ((1234 * sampleSize) == entry[3]), "journal_closed: final entry covers all samples") && ok;
+    return ok;
+}
+
+
+/**
+ * @brief Check the lock-free sample queue and the overflow policies of the binary ring buffer.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ * @details The overflow policies are checked with a shared writer service whose only worker thread is held by another
+ * channel, such that the cache of the binary ring buffer runs full deterministically.
+ */
+static bool CheckSampleQueue(std::filesystem::path directory){
+    bool ok = true;
+
+    // slots, claims and dropping the oldest sample of the queue
+    etf::detail::SampleQueue queue;
+    queue.Resize(8, 4);
+    ok = Expect((4 == queue.Capacity()) && !queue.Size(), "queue: empty after resize") && ok;
+    ok = Expect(queue.Reserve() == queue.Reserve(), "queue: reserve without commit returns the same slot") && ok;
+    for(uint64_t n = 0; n < 4; ++n){
+        ok = Expect(queue.Push(&n, !n, 100 + n), "queue: push sample " + std::to_string(n)) && ok;
+    }
+    uint64_t value = 4;
+    ok = Expect(!queue.Push(&value, false, 104) && !queue.Reserve(), "queue: full queue rejects a sample") && ok;
+    ok = Expect(queue.DropOldest() && (3 == queue.Size()), "queue: drop the oldest sample of a full queue") && ok;
+    ok = Expect(!queue.DropOldest(), "queue: no sample is dropped if the queue is not full") && ok;
+    ok = Expect(queue.Push(&value, false, 104), "queue: push after dropping the oldest sample") && ok;
+    size_t numClaimed = queue.Claim();
+    ok = Expect(4 == numClaimed, "queue: claim all samples") && ok;
+    ok = Expect(!queue.DropOldest(), "queue: claimed samples are not dropped") && ok;
+    ok = Expect((3 == queue.Contiguous(0)) && (4 == queue.Contiguous(3)), "queue: contiguous samples end at the end of the slot memory") && ok;
+    for(size_t k = 0; k < numClaimed; ++k){
+        std::memcpy(&value, queue.Sample(k), sizeof(value));
+        ok = Expect((value == (k + 1)) && !queue.Flag(k) && ((101 + k) == queue.Timestamp(k)) && (8 == *queue.Lengths(k)), "queue: claimed sample " + std::to_string(k) + " is the pushed sample " + std::to_string(k + 1)) && ok;
+    }
+    queue.Pop(0);
+    ok = Expect(4 == queue.Size(), "queue: an empty pop keeps all samples") && ok;
+    queue.Pop(numClaimed);
+    ok = Expect(!queue.Size() && !queue.Claim() && queue.Push(&value, false, 105), "queue: empty after pop") && ok;
+
+    // overflow policies, the held worker thread does not drain the cache
+    const etf::detail::ThreadOptions threadOptions = {etf::detail::ThreadPolicy::other, 0, {}};
+    const etf::OverflowPolicy policies[] = {etf::OverflowPolicy::drop_newest, etf::OverflowPolicy::drop_oldest, etf::OverflowPolicy::block};
+    const char* policyNames[] = {"drop_newest", "drop_oldest", "block"};
+    const size_t sampleSize = 16, maxNumCachedSamples = 8, numOverflows = 4;
+    for(size_t p = 0; p < 3; ++p){
+        const std::string name = policyNames[p];
+        std::shared_ptr<etf::detail::WriterService> service = std::make_shared<etf::detail::WriterService>(1, threadOptions);
+        std::atomic<bool> held(false), released(false);
+        etf::detail::WriterService::channel* holder = service->Register([&held, &released](){
+            held = true;
+            while(!released){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }, [](){});
+        service->NotifyWrite(holder);
+        ok = Expect(WaitUntil([&held](){ return held.load(); }), name + ": worker thread is held") && ok;
+        etf::BinaryRingBuffer ringBuffer;
+        ringBuffer.SetWriterService(service);
+        ringBuffer.Initialize((directory / name).string().c_str(), sampleSize, 100, 2, 0, maxNumCachedSamples, policies[p], 100000);
+        std::vector<uint8_t> sample(sampleSize);
+        uint64_t n = 0;
+        for(; n < maxNumCachedSamples; ++n){
+            MakeSample(&sample[0], sampleSize, n);
+            ok = Expect((n + 1) == ringBuffer.AddSample(&sample[0], false), name + ": sample " + std::to_string(n) + " is cached") && ok;
+        }
+        for(size_t k = 0; k < numOverflows; ++k, ++n){
+            MakeSample(&sample[0], sampleSize, n);
+            (void)ringBuffer.AddSample(&sample[0], false);
+        }
+        ok = Expect(numOverflows == ringBuffer.GetNumDroppedSamples(), name + ": " + std::to_string(ringBuffer.GetNumDroppedSamples()) + " samples dropped, expected " + std::to_string(numOverflows)) && ok;
+
+        // a blocked sample is added as soon as the worker thread makes room, the dropped samples are added again
+        uint64_t firstSample = (etf::OverflowPolicy::drop_oldest == policies[p]) ? numOverflows : 0;
+        uint64_t lastSample = (etf::OverflowPolicy::drop_newest == policies[p]) ? (maxNumCachedSamples - 1) : (n - 1);
+        if(etf::OverflowPolicy::block == policies[p]){
+            std::thread releaser([&released](){
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                released = true;
+            });
+            for(n = maxNumCachedSamples; n <= lastSample; ++n){
+                MakeSample(&sample[0], sampleSize, n);
+                (void)ringBuffer.AddSample(&sample[0], false);
+            }
+            releaser.join();
+            ok = Expect(numOverflows == ringBuffer.GetNumDroppedSamples(), name + ": no sample dropped after the worker thread has been released") && ok;
+        }
+        released = true;
+        ringBuffer.Terminate();
+        service->Unregister(holder);
+        std::vector<std::filesystem::path> directories = FindRingDirectories(directory / name);
+        if(Expect(1 == directories.size(), name + ": one ring buffer directory")){
+            ok = ExpectReplay(directories[0], sampleSize, firstSample, lastSample, name) && ok;
+        }
+        else{
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+
+/**
+ * @brief Check the direct I/O backend, which pads each file to whole blocks and writes through an aligned staging buffer.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed or if the file system does not support O_DIRECT, false otherwise.
+ */
+static bool CheckDirectIO(std::filesystem::path directory){
+    int fd = open((directory / "probe").string().c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if(fd < 0){
+        printf("direct_io: O_DIRECT is not supported in %s, check skipped\n", directory.string().c_str());
+        return true;
+    }
+    close(fd);
+    bool ok = true;
+    const size_t sampleSize = 24, numSamplesPerFile = 100, numFiles = 3, blockSize = 4096;
+    for(size_t flushBytes : {size_t(0), size_t(100)}){
+        // numSamples: incomplete last block, exactly full, wrapped in the middle of a block of the first file
+        for(uint64_t numSamples : {uint64_t(150), uint64_t(300), uint64_t(1234)}){
+            etf::detail::MultiFileRingBufferOptions options;
+            options.backend = etf::detail::MultiFileRingBufferBackend::direct_io;
+            options.flush_bytes = flushBytes;
+            std::string name = "direct_io_" + std::to_string(flushBytes) + "_" + std::to_string(numSamples);
+            std::filesystem::path folder = directory / name;
+            const uint64_t capacity = numSamplesPerFile * numFiles;
+            ok = Expect(WriteRingBuffer(folder, sampleSize, numSamplesPerFile, numFiles, numSamples, options), name + ": ring buffer opens") && ok;
+            for(size_t k = 0; k < numFiles; ++k){
+                std::error_code ec;
+                uintmax_t fileSize = std::filesystem::file_size(folder / ("buffer" + std::to_string(k) + ".dat"), ec);
+                ok = Expect(!ec && !(fileSize % blockSize) && (fileSize <= blockSize), name + ": file " + std::to_string(k) + " is padded to whole blocks") && ok;
+            }
+
+            // the replay of a wrapped ring buffer includes the old samples behind the writing point of the last block
+            ok = ExpectReplay(folder, sampleSize, (numSamples > capacity) ? (numSamples - capacity) : 0, numSamples - 1, name) && ok;
+        }
+    }
+    return ok;
+}
+
+
+/**
+ * @brief Check the io_uring backend with staging buffers of different sizes.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ * @details Staging buffers that are smaller than a sample or that do not divide the file size split the data into many
+ * write requests that are in flight at the same time. If io_uring is not available, the backend falls back to stdio
+ * streams and the replay is checked anyway.
+ */
+static bool CheckIOUring(std::filesystem::path directory){
+    bool ok = true;
+    const size_t sampleSize = 24, numSamplesPerFile = 100, numFiles = 3;
+    const size_t bufferLayouts[][2] = {{1, 16}, {2, 100}, {8, 4096}, {8, 1 << 16}};
+    for(auto&& layout : bufferLayouts){
+        for(uint64_t numSamples : {uint64_t(150), uint64_t(1234)}){
+            etf::detail::MultiFileRingBufferOptions options;
+            options.backend = etf::detail::MultiFileRingBufferBackend::io_uring_async;
+            options.async_num_buffers = layout[0];
+            options.async_buffer_size = layout[1];
+            options.flush_bytes = 1000;
+            std::string name = "io_uring_" + std::to_string(layout[0]) + "x" + std::to_string(layout[1]) + "_" + std::to_string(numSamples);
+            std::filesystem::path folder = directory / name;
+            const uint64_t capacity = numSamplesPerFile * numFiles;
+            ok = Expect(WriteRingBuffer(folder, sampleSize, numSamplesPerFile, numFiles, numSamples, options), name + ": ring buffer opens") && ok;
+            ok = ExpectReplay(folder, sampleSize, (numSamples > capacity) ? (numSamples - capacity) : 0, numSamples - 1, name) && ok;
+        }
+    }
+
+    // compressed blocks are written as records of varying size
+    etf::detail::MultiFileRingBufferOptions options;
+    options.backend = etf::detail::MultiFileRingBufferBackend::io_uring_async;
+    options.async_num_buffers = 2;
+    options.async_buffer_size = 100;
+    options.codec = etf::detail::MultiFileRingBufferCodec::lz4;
+    options.block_num_samples = 16;
+    ok = Expect(WriteRingBuffer(directory / "io_uring_lz4", sampleSize, numSamplesPerFile, numFiles, 5000, options), "io_uring_lz4: ring buffer opens") && ok;
+    ok = ExpectReplay(directory / "io_uring_lz4", sampleSize, UINT64_MAX, 4999, "io_uring_lz4") && ok;
+    return ok;
+}
+
+
+/**
+ * @brief Check variable-length records written by the binary ring buffer and the length of fixed-length samples.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckVariableLength(std::filesystem::path directory){
+    bool ok = true;
+    const etf::detail::ThreadOptions threadOptions = {etf::detail::ThreadPolicy::other, 0, {}};
+    const size_t sampleSize = 40;
+    for(bool variableLength : {true, false}){
+        const std::string name = variableLength ? "variable_length" : "fixed_length";
+        etf::detail::MultiFileRingBufferOptions options;
+        options.variable_length = variableLength;
+        etf::BinaryRingBuffer ringBuffer;
+        ringBuffer.SetThreadOptions(threadOptions);
+        ringBuffer.Initialize((directory / name).string().c_str(), sampleSize, 50, 3, 0, 4096, etf::OverflowPolicy::drop_newest, 0, 0, options);
+        std::vector<uint8_t> sample(sampleSize);
+        const uint64_t numSamples = 1000;
+        for(uint64_t n = 0; n < numSamples; ++n){
+            MakeSample(&sample[0], sampleSize, n);
+            // lengths greater than the sample size are limited to the sample size, a fixed-length ring buffer ignores the length
+            size_t length = RecordLength(n, sampleSize);
+            length = (length == sampleSize) ? (length + 10) : length;
+            if(n % 2){
+                (void)ringBuffer.AddSample(&sample[0], length, false);
+            }
+            else{
+                void* slot = ringBuffer.ReserveSample();
+                if(slot){
+                    std::memcpy(slot, &sample[0], sampleSize);
+                    (void)ringBuffer.CommitSample(false, length);
+                }
+            }
+            if(variableLength && (500 == n)){
+                (void)ringBuffer.AddSample(&sample[0], 0, false); // a record without valid bytes is not written
+            }
+        }
+        ok = Expect(!ringBuffer.GetNumDroppedSamples(), name + ": no sample dropped") && ok;
+        ringBuffer.Terminate();
+        std::vector<std::filesystem::path> directories = FindRingDirectories(directory / name);
+        if(Expect(1 == directories.size(), name + ": one ring buffer directory")){
+            ok = ExpectReplay(directories[0], sampleSize, variableLength ? UINT64_MAX : (numSamples - 150), numSamples - 1, name, variableLength) && ok;
+        }
+        else{
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+
+/**
+ * @brief Read all entries of a time index file.
+ * @param[in] filename Path of the time index file.
+ * @return All entries (sample_number, monotonic_ns, utc_ns, byte_offset).
+ */
+static std::vector<std::array<int64_t, 4>> ReadTimeIndex(std::filesystem::path filename){
+    std::vector<std::array<int64_t, 4>> entries;
+    FILE* fp = fopen(filename.string().c_str(), "rb");
+    if(fp){
+        std::array<int64_t, 4> entry;
+        while(1 == fread(entry.data(), sizeof(entry), 1, fp)){
+            entries.push_back(entry);
+        }
+        fclose(fp);
+    }
+    return entries;
+}
+
+
+/**
+ * @brief Check the time index files of raw samples and of compressed blocks.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckTimeIndex(std::filesystem::path directory){
+    bool ok = true;
+    const size_t sampleSize = 16, numSamplesPerFile = 100, numFiles = 3, interval = 10;
+
+    // raw samples: one entry every interval samples, the entries of overwritten files are removed
+    for(uint64_t numSamples : {uint64_t(250), uint64_t(1234)}){
+        etf::detail::MultiFileRingBufferOptions options;
+        options.time_index_interval_samples = interval;
+        std::string name = "time_index_" + std::to_string(numSamples);
+        std::filesystem::path folder = directory / name;
+        ok = Expect(WriteRingBuffer(folder, sampleSize, numSamplesPerFile, numFiles, numSamples, options), name + ": ring buffer opens") && ok;
+        int64_t utcOffset = 0;
+        bool first = true;
+        for(size_t k = 0; k < numFiles; ++k){
+            // samples of the latest revolution of this file
+            uint64_t begin = k * numSamplesPerFile;
+            while((begin + numSamplesPerFile * numFiles) < numSamples){
+                begin += numSamplesPerFile * numFiles;
+            }
+            uint64_t end = ((begin + numSamplesPerFile) < numSamples) ? (begin + numSamplesPerFile) : numSamples;
+            uint64_t numExpected = (begin < numSamples) ? ((end - begin + interval - 1) / interval) : 0;
+            std::vector<std::array<int64_t, 4>> entries = ReadTimeIndex(folder / ("buffer" + std::to_string(k) + ".idx"));
+            const std::string what = name + ": file " + std::to_string(k);
+            ok = Expect(numExpected == entries.size(), what + " has " + std::to_string(entries.size()) + " entries, expected " + std::to_string(numExpected)) && ok;
+            for(size_t i = 0; i < entries.size(); ++i){
+                uint64_t sampleNumber = begin + i * interval;
+                ok = Expect(static_cast<int64_t>(sampleNumber) == entries[i][0], what + ": entry " + std::to_string(i) + " is sample " + std::to_string(entries[i][0]) + ", expected " + std::to_string(sampleNumber)) && ok;
+                ok = Expect(static_cast<int64_t>((sampleNumber - begin) * sampleSize) == entries[i][3], what + ": entry " + std::to_string(i) + " points to the sample") && ok;
+                ok = Expect(!i || (entries[i][1] >= entries[i - 1][1]), what + ": entry " + std::to_string(i) + " has a monotonic timestamp") && ok;
+                ok = Expect(first || ((entries[i][2] - entries[i][1]) == utcOffset), what + ": entry " + std::to_string(i) + " has a constant UTC offset") && ok;
+                utcOffset = entries[i][2] - entries[i][1];
+                first = false;
+            }
+        }
+    }
+
+    // blocks: at most one entry per block that points to the block record
+    etf::detail::MultiFileRingBufferOptions options;
+    options.time_index_interval_samples = interval;
+    options.codec = etf::detail::MultiFileRingBufferCodec::lz4;
+    options.block_num_samples = 32;
+    ok = Expect(WriteRingBuffer(directory / "time_index_lz4", sampleSize, numSamplesPerFile, numFiles, 5000, options), "time_index_lz4: ring buffer opens") && ok;
+    size_t numEntries = 0;
+    for(size_t k = 0; k < numFiles; ++k){
+        std::vector<std::array<int64_t, 4>> entries = ReadTimeIndex(directory / "time_index_lz4" / ("buffer" + std::to_string(k) + ".idx"));
+        for(size_t i = 0; i < entries.size(); ++i){
+            const std::string what = "time_index_lz4: file " + std::to_string(k) + " entry " + std::to_string(i);
+            ok = Expect(!(entries[i][0] % 32) && (entries[i][0] < 5000), what + " is the first sample of a block") && ok;
+            ok = Expect(!i || ((entries[i][0] > entries[i - 1][0]) && (entries[i][3] > entries[i - 1][3])), what + " follows the previous entry") && ok;
+            ok = Expect((entries[i][3] >= 0) && (entries[i][3] < static_cast<int64_t>(numSamplesPerFile * sampleSize)), what + " points into the file") && ok;
+        }
+        numEntries += entries.size();
+    }
+    ok = Expect(numEntries > 0, "time_index_lz4: entries are written") && ok;
+    FILE* fp = fopen((directory / "time_index_lz4" / "complete.json").string().c_str(), "rb");
+    std::string json;
+    if(fp){
+        char buffer[4096];
+        size_t n;
+        while((n = fread(buffer, 1, sizeof(buffer), fp)) > 0){
+            json.append(buffer, n);
+        }
+        fclose(fp);
+    }
+    ok = Expect(std::string::npos != json.find("\"time_index\""), "time_index_lz4: complete.json describes the time index") && ok;
+    return ok;
+}
+
+
+/**
+ * @brief Check binary ring buffers that share the threads of a writer service.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckWriterService(std::filesystem::path directory){
+    bool ok = true;
+    const etf::detail::ThreadOptions threadOptions = {etf::detail::ThreadPolicy::other, 0, {}};
+
+    // a group shares one service that is destroyed when the last user releases it
+    std::shared_ptr<etf::detail::WriterService> a = etf::detail::WriterService::Acquire(11, 2, threadOptions);
+    std::shared_ptr<etf::detail::WriterService> b = etf::detail::WriterService::Acquire(11, 4, threadOptions);
+    std::shared_ptr<etf::detail::WriterService> c = etf::detail::WriterService::Acquire(12, 1, threadOptions);
+    ok = Expect(a && (a == b) && (a != c), "writer service: one service per group") && ok;
+    std::weak_ptr<etf::detail::WriterService> released = a;
+    a.reset();
+    b.reset();
+    ok = Expect(released.expired(), "writer service: released by the last user") && ok;
+
+    // several ring buffers share two worker threads, one of them starts a new ring buffer
+    const size_t sampleSize = 32, numRingBuffers = 5, numSamplesPerFile = 100, numFiles = 4;
+    const uint64_t numSamples = 5000, numSamplesFirstRing = 2500;
+    std::shared_ptr<etf::detail::WriterService> service = etf::detail::WriterService::Acquire(13, 2, threadOptions);
+    std::vector<std::unique_ptr<etf::BinaryRingBuffer>> ringBuffers;
+    for(size_t i = 0; i < numRingBuffers; ++i){
+        ringBuffers.push_back(std::make_unique<etf::BinaryRingBuffer>());
+        ringBuffers.back()->SetWriterService(service);
+        ringBuffers.back()->Initialize((directory / ("shared" + std::to_string(i))).string().c_str(), sampleSize, numSamplesPerFile, numFiles, 0, 256, etf::OverflowPolicy::block, 1000000);
+        ok = Expect(!ringBuffers.back()->GetThreadError(), "shared" + std::to_string(i) + ": threads of the service started") && ok;
+    }
+    std::vector<uint8_t> sample(sampleSize);
+    for(uint64_t n = 0; n < numSamples; ++n){
+        MakeSample(&sample[0], sampleSize, n);
+        for(size_t i = 0; i < numRingBuffers; ++i){
+            (void)ringBuffers[i]->AddSample(&sample[0], !i && (numSamplesFirstRing == n));
+        }
+    }
+    for(size_t i = 0; i < numRingBuffers; ++i){
+        const std::string name = "shared" + std::to_string(i);
+        ok = Expect(!ringBuffers[i]->GetNumDroppedSamples(), name + ": no sample dropped") && ok;
+        ringBuffers[i]->Terminate();
+        std::vector<std::filesystem::path> directories = FindRingDirectories(directory / name);
+        if(!Expect(directories.size() == (i ? 1 : 2), name + ": " + std::to_string(directories.size()) + " ring buffer directories")){
+            ok = false;
+            continue;
+        }
+        if(!i){
+            ok = ExpectReplay(directories[0], sampleSize, numSamplesFirstRing - numSamplesPerFile * numFiles, numSamplesFirstRing - 1, name + " first ring") && ok;
+        }
+        ok = ExpectReplay(directories.back(), sampleSize, numSamples - numSamplesPerFile * numFiles, numSamples - 1, name) && ok;
+    }
+    ringBuffers.clear();
+    service.reset();
+
+    // a periodic wakeup writes and flushes samples below the notification watermark
+    service = std::make_shared<etf::detail::WriterService>(1, threadOptions, std::chrono::microseconds(1000));
+    etf::detail::MultiFileRingBufferOptions options;
+    options.flush_period_ms = 1;
+    etf::BinaryRingBuffer ringBuffer;
+    ringBuffer.SetWriterService(service);
+    ringBuffer.SetWakeupCoalescing(1000, 0);
+    ringBuffer.Initialize((directory / "periodic").string().c_str(), sampleSize, numSamplesPerFile, numFiles, 0, 4096, etf::OverflowPolicy::drop_newest, 0, 0, options);
+    const uint64_t numPeriodicSamples = 10;
+    for(uint64_t n = 0; n < numPeriodicSamples; ++n){
+        MakeSample(&sample[0], sampleSize, n);
+        (void)ringBuffer.AddSample(&sample[0], false);
+    }
+    ok = Expect(WaitUntil([&](){
+        std::vector<std::filesystem::path> directories = FindRingDirectories(directory / "periodic");
+        std::error_code ec;
+        return (1 == directories.size()) && (std::filesystem::file_size(directories[0] / "buffer0.dat", ec) >= (numPeriodicSamples * sampleSize)) && !ec;
+    }), "periodic: samples are written and flushed without a notification") && ok;
+    ringBuffer.Terminate();
+    std::vector<std::filesystem::path> directories = FindRingDirectories(directory / "periodic");
+    ok = Expect(1 == directories.size(), "periodic: one ring buffer directory") && ok;
+    ok = !directories.empty() && ExpectReplay(directories[0], sampleSize, 0, numPeriodicSamples - 1, "periodic") && ok;
+    return ok;
+}
+
+
+/**
+ * @brief Check the startup file for all modes of loading the data.
+ * @param[in] directory Scratch directory.
+ * @return True if the check passed, false otherwise.
+ */
+static bool CheckStartupFile(std::filesystem::path directory){
+    bool ok = true;
+    const std::string filename = (directory / "startup.bin").string();
+    std::vector<uint8_t> content(10123);
+    for(size_t i = 0; i < content.size(); ++i){
+        content[i] = static_cast<uint8_t>((i * 7) + (i / 256));
+    }
+    FILE* fp = fopen(filename.c_str(), "wb");
+    ok = Expect(fp && (content.size() == fwrite(content.data(), 1, content.size(), fp)), "startup file: written") && ok;
+    if(fp){
+        fclose(fp);
+    }
+
+    // buffered, memory-mapped (with and without locked pages) and asynchronous
+    const uint32_t maxNumBytes = 8000;
+    std::vector<uint8_t> output(maxNumBytes), other(maxNumBytes);
+    for(size_t mode = 0; mode < 4; ++mode){
+        const char* modeNames[] = {"buffered", "memory_mapped", "locked", "asynchronous"};
+        const std::string name = modeNames[mode];
+        etf::StartupFileOptions options;
+        options.memory_mapped = (1 == mode) || (2 == mode);
+        options.lock_memory = (2 == mode);
+        options.asynchronous = (3 == mode);
+        options.thread_options = {etf::detail::ThreadPolicy::other, 0, {}};
+        etf::StartupFile startupFile;
+        startupFile.Initialize(filename.c_str(), maxNumBytes, options);
+        ok = Expect(WaitUntil([&startupFile](){ return startupFile.IsReady(); }), name + ": data is ready") && ok;
+        ok = Expect(startupFile.GetData() && (maxNumBytes == startupFile.GetLength()) && (0 == std::memcmp(startupFile.GetData(), content.data(), maxNumBytes)), name + ": data matches the file") && ok;
+        uint32_t length = 0;
+        ok = Expect(startupFile.GetBytes(output.data(), &length, maxNumBytes) && (maxNumBytes == length) && (0 == std::memcmp(output.data(), content.data(), length)), name + ": first output is new data") && ok;
+        ok = Expect(!startupFile.GetBytes(output.data(), &length, maxNumBytes) && (maxNumBytes == length), name + ": second output is unchanged") && ok;
+        ok = Expect(!startupFile.GetBytes(other.data(), &length, 100, true) && (100 == length) && (0 == std::memcmp(other.data(), content.data(), length)), name + ": data is copied once into another output array") && ok;
+        uint32_t version = startupFile.GetVersion();
+        startupFile.Initialize(filename.c_str(), 20000, options);
+        ok = Expect(WaitUntil([&startupFile](){ return startupFile.IsReady(); }) && (content.size() == startupFile.GetLength()) && (version != startupFile.GetVersion()), name + ": the whole file is loaded again") && ok;
+        ok = Expect(startupFile.GetBytes(output.data(), &length, maxNumBytes) && (maxNumBytes == length), name + ": new data after loading again is limited to the output array") && ok;
+        startupFile.Initialize((directory / "missing.bin").string().c_str(), maxNumBytes, options);
+        ok = Expect(WaitUntil([&startupFile](){ return startupFile.IsReady(); }) && !startupFile.GetLength(), name + ": a missing file is ready without data") && ok;
+        (void)startupFile.GetBytes(output.data(), &length, maxNumBytes);
+        ok = Expect(!length, name + ": no bytes are output for a missing file") && ok;
+    }
+
+    // shared data for the same file, size and storage
+    etf::StartupFileOptions sharedOptions;
+    sharedOptions.shared = true;
+    etf::StartupFileOptions mappedOptions = sharedOptions;
+    mappedOptions.memory_mapped = true;
+    etf::StartupFile first, second, mapped, smaller, unshared;
+    first.Initialize(filename.c_str(), maxNumBytes, sharedOptions);
+    second.Initialize(filename.c_str(), maxNumBytes, sharedOptions);
+    mapped.Initialize(filename.c_str(), maxNumBytes, mappedOptions);
+    smaller.Initialize(filename.c_str(), maxNumBytes / 2, sharedOptions);
+    unshared.Initialize(filename.c_str(), maxNumBytes);
+    ok = Expect(first.GetData() && (first.GetData() == second.GetData()), "shared: same data for the same file") && ok;
+    ok = Expect(mapped.GetData() && (mapped.GetData() != first.GetData()) && (0 == std::memcmp(mapped.GetData(), content.data(), maxNumBytes)), "shared: data is not shared between buffered and memory-mapped storage") && ok;
+    ok = Expect(smaller.GetData() && (smaller.GetData() != first.GetData()) && ((maxNumBytes / 2) == smaller.GetLength()), "shared: data is not shared between different sizes") && ok;
+    ok = Expect(unshared.GetData() && (unshared.GetData() != first.GetData()), "shared: unshared data is separate") && ok;
+    const uint8_t* data = second.GetData();
+    first.Terminate();
+    ok = Expect((data == second.GetData()) && (0 == std::memcmp(data, content.data(), maxNumBytes)), "shared: data stays valid for the remaining user") && ok;
+
+    // streaming in slices through two chunk buffers, synchronously prefetched and asynchronously prefetched
+    const uint32_t sliceSize = 1000;
+    for(bool asynchronous : {false, true}){
+        const std::string name = asynchronous ? "streaming_asynchronous" : "streaming";
+        etf::StartupFileOptions options;
+        options.streaming = true;
+        options.stream_chunk_size = 2500;
+        options.asynchronous = asynchronous;
+        options.thread_options = {etf::detail::ThreadPolicy::other, 0, {}};
+        etf::StartupFile startupFile;
+        startupFile.Initialize(filename.c_str(), sliceSize, options);
+        ok = Expect(!startupFile.GetData(), name + ": no data pointer") && ok;
+        std::vector<uint8_t> streamed, slice(sliceSize);
+        bool sliceSizes = true;
+        bool ended = WaitUntil([&](){
+            uint32_t length = 0;
+            size_t numUnderruns = startupFile.GetNumUnderruns();
+            if(startupFile.GetBytes(slice.data(), &length, sliceSize)){
+                size_t numRemaining = content.size() - ((streamed.size() < content.size()) ? streamed.size() : content.size());
+                sliceSizes = sliceSizes && (length == ((numRemaining < sliceSize) ? numRemaining : sliceSize));
+                streamed.insert(streamed.end(), slice.begin(), slice.begin() + length);
+                return false;
+            }
+            return !length && (numUnderruns == startupFile.GetNumUnderruns()); // end of file, not an underrun
+        });
+        ok = Expect(ended && sliceSizes && (streamed == content), name + ": slices match the file") && ok;
+    }
+    return ok;
+}
+
+
+int main(int argc, char** argv){
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string check;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        if((arg == "--directory") && ((i + 1) < argc)){
+            directory = argv[++i];
+        }
+        else if(check.empty() && (arg.rfind("--", 0) != 0)){
+            check = arg;
+        }
+        else{
+            check.clear();
+            break;
+        }
+    }
+    bool (*function)(std::filesystem::path) = nullptr;
+    function = (check == "lz4_round_trip") ? &CheckLZ4RoundTrip : function;
+    function = (check == "reader_replay") ? &CheckReaderReplay : function;
+    function = (check == "journal_recovery") ? &CheckJournalRecovery : function;
+    function = (check == "sample_queue") ? &CheckSampleQueue : function;
+    function = (check == "direct_io") ? &CheckDirectIO : function;
+    function = (check == "io_uring") ? &CheckIOUring : function;
+    function = (check == "variable_length") ? &CheckVariableLength : function;
+    function = (check == "time_index") ? &CheckTimeIndex : function;
+    function = (check == "writer_service") ? &CheckWriterService : function;
+    function = (check == "startup_file") ? &CheckStartupFile : function;
+    if(!function){
+        fprintf(stderr, "usage: %s lz4_round_trip|reader_replay|journal_recovery|sample_queue|direct_io|io_uring|variable_length|time_index|writer_service|startup_file [--directory <dir>]\n", argv[0]);
+        return 1;
+    }
+    directory /= "etf_tests_" + check + "_" + std::to_string(static_cast<long long>(getpid()));
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if(ec){
+        fprintf(stderr, "could not create directory %s\n", directory.string().c_str());
+        return 1;
+    }
+    bool passed = function(directory);
+    std::filesystem::remove_all(directory, ec);
+    printf("%s: %s\n", check.c_str(), passed ? "passed" : "failed");
+    return passed ? 0 : 1;
+}